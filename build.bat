@@ -1,2 +1,2 @@
 @echo off
-gcc -Wall -g3 -o bslides.exe src\bslides.c
+gcc -Wall -g3 -o bslides.exe src\bslides.c -lpthread
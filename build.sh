@@ -1,3 +1,3 @@
 #!/usr/bin/env bash
-gcc -Wall -g3 -o bslides src/bslides.c -lm
+gcc -Wall -g3 -o bslides src/bslides.c -lm -lpthread
 
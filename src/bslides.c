@@ -47,6 +47,21 @@
 #include <stdbool.h>
 #include <time.h>
 #include <ctype.h>
+#include <math.h>
+#include <limits.h>
+
+#include <pthread.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <poll.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(BSLIDES_NOSIMD)
+#define BSLIDES_X86
+#include <immintrin.h>
+#endif
 
 #define COMMON_IMPLEMENTATION
 #include "common.h"
@@ -57,6 +72,10 @@
 #include "stb_image_resize.h"
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb_image_write.h"
+// NOTE (brian): stb_truetype allocates with the fontinfo's userdata, which is either NULL (the heap),
+// or the rendering thread's scratch arena
+#define STBTT_malloc(x,u) ((u) ? arena_alloc((struct arena_t *)(u), (x)) : malloc(x))
+#define STBTT_free(x,u)   ((u) ? (void)0 : free(x))
 #define STB_TRUETYPE_IMPLEMENTATION
 #include "stb_truetype.h"
 
@@ -69,7 +88,28 @@
 #define DEFAULT_FONT_SIZE  (32)
 #define MAX_LINES_ON_SLIDE (32)
 
-#define MAX_FUNCTIONS (BUFSMALL)
+// NOTE (brian): bump this whenever rendering changes, so old cache entries stop matching
+#define BSLIDES_CACHEVERSION ("bslides-8")
+
+#define WATCH_DEBOUNCE (50) // milliseconds of quiet before a change gets rendered
+
+// NOTE (brian): and bump this whenever glyph rasterization, or the on disk glyph cache's layout, changes
+#define GLYPHCACHE_MAGIC ("bsglyph3")
+
+// NOTE (brian): with --sdf, every glyph is a distance field rasterized at SDF_SIZE, and drawn at
+// any size from that. A field value of SDF_ONEDGE is on the outline, and it changes by
+// SDF_DISTSCALE per pixel (at SDF_SIZE) away from it, out to SDF_PADDING pixels.
+#define SDF_SIZE      (64)
+#define SDF_PADDING   (8)
+#define SDF_ONEDGE    (128)
+#define SDF_DISTSCALE (16.0f)
+
+// NOTE (brian): text is laid out in 26.6 fixed point, and coverage glyphs are rasterized at this
+// many horizontal offsets within a pixel; each glyph gets drawn with the one nearest its position
+#define SUBPIXEL_STEPS (4)
+
+// NOTE (brian): what a malformed utf-8 sequence decodes to, one per bad byte
+#define UTF8_REPLACEMENT (0xfffd)
 
 struct pixel_t {
 	u8 r, g, b, a;
@@ -113,41 +153,140 @@ enum {
 	, FRAMEBUFFER_TOTAL
 };
 
+// NOTE (brian): glyphs for one (font, size) get packed into pages by stb_truetype, as 8 bit
+// coverage, and get drawn from there with draw_mask, in whatever color the template says
+struct atlaspage_t {
+	struct atlaspage_t *next;
+	s32 w, h;
+	u8 *coverage;
+	stbtt_pack_context pack;
+};
+
+struct atlas_t {
+	struct atlas_t *next;
+	u32 fontsize;
+	s32 side;                  // how big new pages are
+	struct atlaspage_t *pages; // newest first, only the newest gets new glyphs
+};
+
+#define ATLAS_PADDING (1)
+
+// how a glyph was rasterized, part of its key
+enum {
+	  GLYPHMODE_COVERAGE
+	, GLYPHMODE_SDF
+};
+
 struct fchar_t {
-	struct pixel_t *bitmap;
-	// u8 *bitmap;
+	u8 *coverage; // the glyph's top left corner, in an atlas page, or in the on disk cache
+	s32 stride;   // of the rows 'coverage' is in
 	u32 codepoint;
 	u32 fontsize;
+	u32 mode;     // GLYPHMODE_*, SDF glyphs are all SDF_SIZE, and their advance is in font units
+	u32 subx;     // rasterized shifted right by subx / SUBPIXEL_STEPS of a pixel, always 0 for SDF
 	s32 f_x; // font size (in pixels)
 	s32 f_y;
 	s32 b_x; // bearing information
 	s32 b_y;
-	u32 advance;
+	u32 advance; // in 26.6 fixed point
 };
 
-struct font_t {
-	char *name;
-	char *path;
-	char *ttfbuffer;
-	struct fchar_t *ftab;
-	size_t ftab_len, ftab_cap;
-	f32 scale_x, scale_y;
+// NOTE (brian): the kerning between a pair of codepoints, in font units, so one entry serves every
+// size; font_kern scales it
+struct kernpair_t {
+	u32 a, b;
+	s32 kern;
+	s32 used;
+};
+
+// NOTE (brian): the vertical metrics of a font at one size. font_metricsadd works them out once
+// per size the show prints at, everything after that is a table lookup.
+struct fmetrics_t {
+	u32 fontsize;
+	s32 used;
+	f32 scale;
 	s32 ascent;
 	s32 descent;
 	s32 linegap;
-	s32 metricsread;
+	s32 vertadvance;
 };
 
-struct command_t {
-	int argc;
-	char **argv;
+struct font_t {
+	char *name;
+	char *path;
+	char *ttfbuffer; // mapped read only, only the pages stb_truetype touches get read in
+	size_t ttfsize;
+	u64 fileid[2]; // device and inode, every name the show gives one file shares one font
+	u64 hash; // of the file's contents, see font_load
+	stbtt_fontinfo info; // parsed once, in font_load, render threads work off of copies
+	s32 v_ascent, v_descent, v_linegap; // unscaled, in font units
+	s32 advances[128]; // of the ascii codepoints, unscaled, read once in font_load
+	struct fchar_t **ftab; // open addressed on (codepoint, fontsize), the glyphs themselves never move
+	size_t ftab_len, ftab_cap;
+	u64 hits, misses; // ftab lookups, updated atomically
+	struct atlas_t *atlases; // one per size
+	size_t atlas_pages, atlas_bytes;
+	size_t sdf_bytes;
+	char *disk; // the on disk glyph cache, mapped in by font_diskload
+	size_t disk_len;
+	size_t disk_glyphs; // how many glyphs in ftab are already on disk
+	struct kernpair_t *kerns; // open addressed on (a, b), filled in by show_snapshot, read only while rendering
+	size_t kerns_len, kerns_cap;
+	struct fmetrics_t *metrics; // open addressed on the size, filled in by show_snapshot, read only while rendering
+	size_t metrics_len, metrics_cap;
+	struct textrun_t **runs; // open addressed on the run's key, laid out lines of text in this font
+	size_t runs_len, runs_cap;
+	u64 run_hits, run_misses; // runs lookups, updated atomically
+	size_t strips, strip_bytes;
+	struct arena_t arena;  // the name, path, glyphs and text runs
+	pthread_rwlock_t *lock; // guards ftab, runs and the arena, the slide workers share fonts
+	s32 stale; // watch mode, the file changed since it was loaded
 };
 
-struct template_t {
+// NOTE (brian): what `fontadd` names, and `fontset` looks up. Several names can point at the same
+// font, if they were added with the same file.
+struct fontname_t {
 	char *name;
-	s32 justification;
-	color_t fg;
-	color_t bg;
+	s32 fontidx;
+};
+
+// NOTE (brian): the on disk glyph cache is a file per font file, named for the hash of the font's
+// contents, laid out as a header, then a table of glyphs, then their coverage, rows packed tight.
+// It gets mapped in, and glyphs point straight into the mapping.
+struct diskheader_t {
+	char magic[8]; // GLYPHCACHE_MAGIC
+	u64 hash;
+	u32 count;
+	u32 pad;
+};
+
+struct diskglyph_t {
+	u32 codepoint;
+	u32 fontsize;
+	u32 mode;
+	u32 subx;
+	s32 f_x, f_y;
+	s32 b_x, b_y;
+	u32 advance;
+	u32 pad;
+	u64 offset; // of the coverage, from the start of the file
+};
+
+// NOTE (brian): a direct indexed table of the ASCII glyphs of one font at one size, the one the
+// show is drawing with. Every render thread has its own, so lookups don't take the font's lock.
+struct glyphcache_t {
+	struct font_t *font;
+	u32 fontsize;
+	u32 mode;
+	struct fchar_t *ascii[SUBPIXEL_STEPS][128];
+	u64 hits;
+};
+
+// NOTE (brian): the arguments are slices into the mapped config file, see show_load
+struct command_t {
+	int argc;
+	struct slice_t *argv;
+	size_t tok; // index of argv[0] in the show's token array
 };
 
 struct settings_t {
@@ -159,14 +298,105 @@ struct settings_t {
 	s32 img_w, img_h;
 };
 
+// NOTE (brian): a slide is the half open range of commands [start, end) between two `newslide`s
+struct slide_t {
+	size_t start;
+	size_t end;
+	struct settings_t entry; // settings as of the slide's `newslide`, from show_snapshot
+	u64 key;                 // render cache key, from cache_slidekey
+	s32 fresh;               // the png on disk was made from 'key'
+};
+
+struct template_t {
+	char *name;
+	s32 justification;
+	color_t fg;
+	color_t bg;
+};
+
+// NOTE (brian): a glyph placed by layout_text, 'x' is the pen position in 26.6 fixed point, and
+// 'line' counts the lines the text wrapped onto before this one
+struct glyphpos_t {
+	u32 codepoint;
+	s32 x;
+	s32 line;
+};
+
+struct layout_t {
+	struct glyphpos_t *glyphs; // NULL when only measuring
+	size_t len;
+	s32 lines;
+};
+
+// NOTE (brian): a line's coverage, every glyph composited into one mask, its corner at (x, y)
+// from the left edge of the slide and the first line's baseline
+struct strip_t {
+	s32 x, y;
+	s32 w, h;
+	u8 coverage[];
+};
+
+// NOTE (brian): a line of text laid out once, and kept in its font, along with everything the layout
+// depended on. Once it's been drawn twice, its strip gets kept too, and from then on it's one blit.
+struct textrun_t {
+	u64 key;
+	u32 *text;
+	size_t text_len;
+	u32 fontsize;
+	u32 mode;
+	s32 justification;
+	s32 pos_x, img_w;
+	struct layout_t layout;
+	u32 uses; // updated atomically
+	struct strip_t *strip; // NULL until it's built, then set once, atomically
+};
+
+
+// NOTE (brian): arguments a command's parse function pulled out of argv ahead of time
+struct args_t {
+	s32 i[4];
+	struct color_t color[2];
+	char *str;
+	size_t str_len;
+	u32 *text;
+	size_t text_len;
+};
+
 struct show_t;
 
-typedef int (showfunc_t) (struct show_t *, int, char **);
+// NOTE (brian): an op is a command with its function already looked up and its arguments parsed,
+// ops[i] always comes from commands[i]
+struct op_t {
+	struct function_t *function;
+	int argc;
+	struct slice_t *argv;
+	struct args_t args;
+};
+
+typedef int (showfunc_t) (struct show_t *, struct op_t *);
+typedef int (parsefunc_t) (struct show_t *, struct op_t *);
 
+typedef void (blendfunc_t) (struct pixel_t *, struct pixel_t *, s32);
+typedef void (maskfunc_t) (struct pixel_t *, u8 *, struct pixel_t, s32);
+typedef void (sdffunc_t) (u8 *, f32 *, f32, f32, s32);
+typedef size_t (asciifunc_t) (u32 *, u8 *, size_t);
+
+// NOTE (brian): 'state' is optional, it applies only an op's effect on show->settings (no drawing),
+// so show_snapshot can walk the whole show cheaply. Functions without one don't touch settings.
 struct function_t {
 	char *name;
 	s32 run_once;
 	showfunc_t *func;
+	parsefunc_t *parse;
+	showfunc_t *state;
+};
+
+// NOTE (brian): the function registry is an open addressed hash table (linear probing) of
+// individually allocated functions, keyed on the name. Entries never move once added, so ops can
+// keep pointers to them while more functions get registered.
+struct functab_t {
+	struct function_t **slots;
+	size_t len, cap;
 };
 
 struct show_t {
@@ -184,18 +414,132 @@ struct show_t {
 	size_t templates_len, templates_cap;
 
 	// function table
-	struct function_t functions[MAX_FUNCTIONS];
-	size_t functions_len;
+	struct functab_t functab;
+
+	// the config file, mapped in, and every token in it
+	char *src;
+	size_t src_len;
+	struct slice_t *tokens;
+	size_t tokens_len, tokens_cap;
 
 	// command strings
 	struct command_t *commands;
 	size_t commands_len, commands_cap;
 
-	// font table
+	// compiled commands, built in show_compile
+	struct op_t *ops;
+	size_t ops_len, ops_cap;
+
+	// slide table, built from the commands in show_load
+	struct slide_t *slides;
+	size_t slides_len, slides_cap;
+
+	// font table, one per font file, and the names they go by
 	struct font_t *fonts;
 	size_t fonts_len, fonts_cap;
+	struct fontname_t *fontnames;
+	size_t fontnames_len, fontnames_cap;
+
+	// watch mode, the fonts from the last load of the show, func_fontadd takes over the ones it can
+	struct font_t *oldfonts;
+	size_t oldfonts_len;
+
+	char *name;
+
+	char *glyphdir; // where fonts keep their glyphs between runs, NULL for nowhere
+	u32 glyphmode;  // how glyphs get rasterized, GLYPHMODE_*
+
+	// NOTE (brian): everything the show allocates while it's loaded and compiled comes out of
+	// 'arena' (the growable tables above are the exception), and goes away in show_free. Render
+	// threads only ever allocate out of 'scratch', which is theirs alone, and reset every slide.
+	struct arena_t arena;
+	struct arena_t scratch;
+
+	// the ascii fast path in front of the fonts' glyph tables, per render thread like scratch
+	struct glyphcache_t glyphs;
+};
+
+// NOTE (brian): a bounded, blocking queue, safe for any number of producers and consumers
+struct queue_t {
+	void **items;
+	size_t head, len, cap;
+	s32 closed;
+	pthread_mutex_t lock;
+	pthread_cond_t notempty, notfull;
+	size_t pushes, occupancy, maxlen; // stats, occupancy / pushes is the average length
+};
+
+// NOTE (brian): a slide on its way through the pipeline, first as pixels, then as a png
+struct frame_t {
+	s32 idx;
+	struct pixel_t *pixels;
+	u8 *png;
+	int png_len;
+};
 
+enum {
+	  STAGE_RENDER
+	, STAGE_ENCODE
+	, STAGE_WRITE
+	, STAGE_TOTAL
+};
+
+struct stage_t {
 	char *name;
+	s32 threads;
+	s32 active; // threads still running, the last one out closes the stage's output queue
+	u64 items;
+	u64 busy;   // nanoseconds spent working, summed over the threads
+};
+
+struct pipeline_t {
+	struct show_t *show;
+	s32 *todo; // slides that need rendering, everything else is cached
+	s32 todo_len;
+	s32 next;  // next slide in 'todo' to render
+	struct queue_t free;   // framebuffers nobody is using
+	struct queue_t encode; // rendered frames
+	struct queue_t write;  // encoded frames
+	struct stage_t stages[STAGE_TOTAL];
+	s32 rc;
+};
+
+// NOTE (brian): a glyph some slide is going to print, found by show_prebake
+struct bake_t {
+	s32 fontidx;
+	u32 fontsize;
+	u32 codepoint;
+	u32 subx;
+};
+
+struct prebake_t {
+	struct show_t *show;
+	struct bake_t *bakes;
+	size_t bakes_len;
+	size_t next; // next glyph in 'bakes' to rasterize
+};
+
+struct bakeworker_t {
+	pthread_t thread;
+	struct prebake_t *prebake;
+	struct arena_t scratch;
+};
+
+// NOTE (brian): a render worker owns a shallow copy of the show. The copy shares everything that's
+// read only while rendering (ops, slides, templates, fonts), but has its own framebuffers and
+// settings, so workers never step on each other.
+struct worker_t {
+	pthread_t thread;
+	struct show_t show;
+	struct pipeline_t *pipeline;
+};
+
+// NOTE (brian): a file watch mode is keeping an eye on
+struct watch_t {
+	s32 wd;     // the watch on the file's directory
+	char *path; // as the show wrote it
+	char *base; // file name, what inotify reports
+	s32 changed;
 };
 
 // Slideshow Init & Free Functions
@@ -203,47 +547,194 @@ struct show_t {
 int show_load(struct show_t *show, char *config);
 /* show_free : frees everything related to the slideshow */
 int show_free(struct show_t *show);
+/* show_compile : resolves and parses every command, running the run once commands */
+int show_compile(struct show_t *show);
+/* show_snapshot : records the settings every slide starts with, without rendering anything */
+int show_snapshot(struct show_t *show);
 
 // Slideshow Rendering Functions
 /* show_render : renders the slide 'idx' into its internal buffer */
 int show_render(struct show_t *show, s32 idx);
 /* show_renderimage : renders the image to the slide */
 int show_renderimage(struct show_t *slide, struct image_t *image, s32 x, s32 y);
+/* show_renderall : renders every slide that isn't cached, on 'jobs' threads */
+int show_renderall(struct show_t *show, s32 jobs, s32 usecache, s32 prebake);
+/* show_prebake : rasterizes every glyph the 'todo' slides print, on 'jobs' threads */
+int show_prebake(struct show_t *show, s32 *todo, s32 todo_len, s32 jobs);
+/* show_watch : re-renders whatever changes, whenever the show or anything it loads changes */
+int show_watch(struct show_t *show, char *config, s32 jobs, s32 prebake);
+
+#if defined(__linux__)
+// Watch Mode Functions
+/* watch_add : watches the config file, and every file the show loads */
+int watch_add(s32 fd, struct watch_t **watches, size_t *watches_len, struct show_t *show, char *config);
+/* watch_file : adds a watch on the directory 'path' lives in, for changes to 'path' */
+int watch_file(s32 fd, struct watch_t *watches, size_t *watches_len, char *path);
+/* watch_changed : returns true if the file at 'path' was seen changing */
+s32 watch_changed(struct watch_t *watches, size_t watches_len, char *path);
+/* watch_free : frees the watch list */
+void watch_free(struct watch_t *watches, size_t watches_len);
+#endif
+
+// Pipeline Functions
+/* pipeline_render : render stage, takes slides off the shared counter until they're gone */
+void *pipeline_render(void *arg);
+/* pipeline_encode : encode stage, turns rendered framebuffers into pngs in memory */
+void *pipeline_encode(void *arg);
+/* pipeline_write : write stage, puts the encoded pngs on disk */
+void *pipeline_write(void *arg);
+/* pipeline_stat : counts one item through the stage, that took 'ns' nanoseconds */
+void pipeline_stat(struct stage_t *stage, u64 ns);
+/* pipeline_report : prints per stage throughput and queue occupancy */
+void pipeline_report(struct pipeline_t *pipeline, u64 wall);
+
+// Prebake Functions
+/* prebake_collect : adds every glyph slide 'idx' prints to the list */
+int prebake_collect(struct show_t *show, s32 idx, struct bake_t **bakes, size_t *bakes_len, size_t *bakes_cap);
+/* prebake_cmp : qsort comparator, orders glyphs by font, then size, then codepoint, then offset */
+int prebake_cmp(const void *a, const void *b);
+/* prebake_worker : rasterizes glyphs off the shared counter until they're gone */
+void *prebake_worker(void *arg);
+
+// Render Cache Functions
+/* cache_slidekey : hashes everything the slide's pixels depend on */
+u64 cache_slidekey(struct show_t *show, s32 idx);
+/* cache_font : returns the font at 'idx', NULL if it doesn't exist */
+struct font_t *cache_font(struct show_t *show, s32 idx);
+/* cache_template : returns the template at 'idx', NULL if it doesn't exist */
+struct template_t *cache_template(struct show_t *show, s32 idx);
+/* cache_load : marks every slide whose png on disk matches its key in the sidecar file as fresh */
+int cache_load(struct show_t *show);
+/* cache_save : writes the key of every fresh slide out to the sidecar file */
+int cache_save(struct show_t *show);
+
+/* queue_init : sets up a bounded queue that holds 'cap' items */
+int queue_init(struct queue_t *queue, size_t cap);
+/* queue_push : adds an item to the queue, blocking while it's full */
+int queue_push(struct queue_t *queue, void *item);
+/* queue_pop : takes an item off of the queue, blocking while it's empty, NULL once it's closed */
+void *queue_pop(struct queue_t *queue);
+/* queue_close : wakes everyone waiting on the queue, pops return NULL once it's drained */
+int queue_close(struct queue_t *queue);
+/* queue_free : frees the queue (but not anything still in it) */
+int queue_free(struct queue_t *queue);
 
 // User Callable (Default) Slideshow Functions
-/* functab_add : adds a callable function into the show */
-int functab_add(struct show_t *show, char *name, s32 run_once, showfunc_t func);
+/* functab_add : adds (or replaces) a callable function in the show */
+int functab_add(struct show_t *show, char *name, s32 run_once, showfunc_t func, parsefunc_t parse, showfunc_t state);
+/* functab_defaults : registers the built in functions */
+int functab_defaults(struct show_t *show);
+/* functab_get : returns the function registered under 'name' ('len' bytes), NULL if there isn't one */
+struct function_t *functab_get(struct show_t *show, char *name, size_t len);
+/* functab_free : frees the function registry */
+int functab_free(struct show_t *show);
 /* func_name : user function ; sets the slideshow name, to be run once */
-int func_name(struct show_t *show, int argc, char **argv);
+int func_name(struct show_t *show, struct op_t *op);
 /* func_blank : user function ; inserts a blank line at the current cursor position */
-int func_blank(struct show_t *show, int argc, char **argv);
+int func_blank(struct show_t *show, struct op_t *op);
 /* func_clear : user function ; clears the framebuffer */
-int func_clear(struct show_t *show, int argc, char **argv);
+int func_clear(struct show_t *show, struct op_t *op);
 /* func_templateadd : user function ; adds / overwrites a template */
-int func_templateadd(struct show_t *show, int argc, char **argv);
+int func_templateadd(struct show_t *show, struct op_t *op);
 /* func_templateset : user function ; sets the current template */
-int func_templateset(struct show_t *show, int argc, char **argv);
+int func_templateset(struct show_t *show, struct op_t *op);
 /* func_dimensions : user function ; sets the output width / height */
-int func_dimensions(struct show_t *show, int argc, char **argv);
+int func_dimensions(struct show_t *show, struct op_t *op);
 /* func_nop : user(ish) function ; does nothing, but show an error */
-int func_nop(struct show_t *show, int argc, char **argv);
+int func_nop(struct show_t *show, struct op_t *op);
 /* func_printdate : user function ; prints the date at the current line */
-int func_printdate(struct show_t *show, int argc, char **argv);
+int func_printdate(struct show_t *show, struct op_t *op);
 /* func_printline : user function ; basically, echo */
-int func_printline(struct show_t *show, int argc, char **argv);
+int func_printline(struct show_t *show, struct op_t *op);
 /* func_fontadd : user function ; loads a font, to be run once */
-int func_fontadd(struct show_t *show, int argc, char **argv);
+int func_fontadd(struct show_t *show, struct op_t *op);
 /* func_fontset : user function ; sets the font */
-int func_fontset(struct show_t *show, int argc, char **argv);
+int func_fontset(struct show_t *show, struct op_t *op);
 /* func_fontsizeset : user function ; sets the font size */
-int func_fontsizeset(struct show_t *show, int argc, char **argv);
+int func_fontsizeset(struct show_t *show, struct op_t *op);
 /* func_imageadd : user function ; loads an image, to be run once */
-int func_imageadd(struct show_t *show, int argc, char **argv);
+int func_imageadd(struct show_t *show, struct op_t *op);
 /* func_imagedraw : user function ; draws the image in an argument dependent way */
-int func_imagedraw(struct show_t *show, int argc, char **argv);
-
+int func_imagedraw(struct show_t *show, struct op_t *op);
+
+// Settings Only Functions (run from show_snapshot)
+/* state_clear : moves the cursor like func_clear, without clearing */
+int state_clear(struct show_t *show, struct op_t *op);
+/* state_templateset : sets the current template, without filling the background */
+int state_templateset(struct show_t *show, struct op_t *op);
+/* state_printline : moves the cursor like func_printline, without drawing */
+int state_printline(struct show_t *show, struct op_t *op);
+
+// Argument Parsing Functions (run from show_compile)
+/* parse_templateadd : parses the template's colors and justification */
+int parse_templateadd(struct show_t *show, struct op_t *op);
+/* parse_templateset : resolves the template name to its index */
+int parse_templateset(struct show_t *show, struct op_t *op);
+/* parse_dimensions : parses the output width / height */
+int parse_dimensions(struct show_t *show, struct op_t *op);
+/* parse_printline : joins the arguments into the line to print */
+int parse_printline(struct show_t *show, struct op_t *op);
+/* parse_fontset : resolves the font name to its index */
+int parse_fontset(struct show_t *show, struct op_t *op);
+/* parse_fontsizeset : parses the font size */
+int parse_fontsizeset(struct show_t *show, struct op_t *op);
+
+// Text Layout Functions
+/* layout_text : wraps and justifies a line of text to the slide, glyphs go in 'scratch' (just measures without it) */
+int layout_text(struct show_t *show, struct font_t *font, u32 *text, size_t len, struct layout_t *layout, struct arena_t *scratch);
+/* layout_justify : moves the glyphs [first, last) of a line 'width' wide, per the current template */
+int layout_justify(struct show_t *show, struct layout_t *layout, size_t first, size_t last, s32 width, s32 maxw);
+/* layout_draw : draws every glyph in the layout, in the current font, size and color */
+int layout_draw(struct show_t *show, struct font_t *font, struct layout_t *layout);
+/* layout_run : returns the text run for the line with the current settings, laying it out if it's new */
+struct textrun_t *layout_run(struct show_t *show, struct font_t *font, u32 *text, size_t len);
+/* layout_findrun : looks for a text run matching 'key', NULL if there isn't one, with the lock held */
+struct textrun_t *layout_findrun(struct font_t *font, struct textrun_t *key);
+/* layout_insertrun : adds a text run to the font's table, with the write lock held */
+int layout_insertrun(struct font_t *font, struct textrun_t *run);
+/* layout_strip : composites the run's glyphs into one coverage strip, handing it to the run if 'keep' */
+struct strip_t *layout_strip(struct show_t *show, struct font_t *font, struct textrun_t *run, int keep);
+
+/* draw_init : selects the fastest row kernels the cpu supports, and the ascii widener */
+void draw_init(void);
 /* draw_rect : blits a rectangle */
 int draw_rect(struct pixel_t *dst, struct pixel_t *src, struct rect_t dstdim, struct rect_t srcdim, struct rect_t dstrect, struct rect_t srcrect, int blend);
+/* draw_mask : blends 'color' onto a rectangle, through an 8 bit coverage mask */
+int draw_mask(struct pixel_t *dst, u8 *src, struct rect_t dstdim, struct rect_t srcdim, struct rect_t dstrect, struct rect_t srcrect, struct pixel_t color);
+/* draw_clip : clips both rectangles against their surfaces, returns 0 if nothing is left */
+int draw_clip(struct rect_t dstdim, struct rect_t srcdim, struct rect_t *dstrect, struct rect_t *srcrect);
+/* draw_sdf : blends 'color' onto dst through a 'w' x 'h' distance field, scaled by 'k', its corner at (x, y) */
+int draw_sdf(struct pixel_t *dst, struct rect_t dstdim, u8 *sdf, s32 stride, s32 w, s32 h, f32 x, f32 y, f32 k, struct pixel_t color, struct arena_t *scratch);
+/* draw_blendrow_scalar : alpha blends 'n' src pixels onto dst, one at a time */
+void draw_blendrow_scalar(struct pixel_t *dst, struct pixel_t *src, s32 n);
+/* draw_maskrow_scalar : blends 'color' onto 'n' dst pixels, by src coverage, one at a time */
+void draw_maskrow_scalar(struct pixel_t *dst, u8 *src, struct pixel_t color, s32 n);
+/* draw_sdfrow_scalar : turns 'n' distances into coverage, smoothstep from 'lo' over 1 / 'inv', one at a time */
+void draw_sdfrow_scalar(u8 *dst, f32 *src, f32 lo, f32 inv, s32 n);
+#if defined(BSLIDES_X86)
+/* draw_blendrow_sse2 : alpha blends 'n' src pixels onto dst, four at a time */
+void draw_blendrow_sse2(struct pixel_t *dst, struct pixel_t *src, s32 n);
+/* draw_blendrow_avx2 : alpha blends 'n' src pixels onto dst, eight at a time */
+void draw_blendrow_avx2(struct pixel_t *dst, struct pixel_t *src, s32 n);
+/* draw_maskrow_sse2 : blends 'color' onto 'n' dst pixels, by src coverage, four at a time */
+void draw_maskrow_sse2(struct pixel_t *dst, u8 *src, struct pixel_t color, s32 n);
+/* draw_maskrow_avx2 : blends 'color' onto 'n' dst pixels, by src coverage, eight at a time */
+void draw_maskrow_avx2(struct pixel_t *dst, u8 *src, struct pixel_t color, s32 n);
+/* draw_sdfrow_sse2 : turns 'n' distances into coverage, smoothstep from 'lo' over 1 / 'inv', four at a time */
+void draw_sdfrow_sse2(u8 *dst, f32 *src, f32 lo, f32 inv, s32 n);
+/* draw_sdfrow_avx2 : turns 'n' distances into coverage, smoothstep from 'lo' over 1 / 'inv', eight at a time */
+void draw_sdfrow_avx2(u8 *dst, f32 *src, f32 lo, f32 inv, s32 n);
+#endif
+/* util_asciiwiden_scalar : widens the ascii prefix of 'n' src bytes into dst, returns its length, eight at a time */
+size_t util_asciiwiden_scalar(u32 *dst, u8 *src, size_t n);
+#if defined(BSLIDES_X86)
+/* util_asciiwiden_sse2 : widens the ascii prefix of 'n' src bytes into dst, returns its length, sixteen at a time */
+size_t util_asciiwiden_sse2(u32 *dst, u8 *src, size_t n);
+/* util_asciiwiden_avx2 : widens the ascii prefix of 'n' src bytes into dst, returns its length, thirty two at a time */
+size_t util_asciiwiden_avx2(u32 *dst, u8 *src, size_t n);
+#endif
+/* util_asciiwiden : the fastest of the above, chosen by draw_init */
+extern asciifunc_t *util_asciiwiden;
 
 // Utility Functions
 /* util_framebuffer : (re)sets the show's internal framebuffer */
@@ -252,26 +743,80 @@ int util_framebuffer(struct show_t *show);
 int util_setdefaults(struct show_t *show);
 /* util_slidecount : counts the number of slides in the slideshow */
 int util_slidecount(struct show_t *show);
-/* util_getfuncidx : gets the function index */
-int util_getfuncidx(struct show_t *show, char *function);
+/* util_slideindex : builds the slide table from the show's commands */
+int util_slideindex(struct show_t *show);
+/* util_fillbg : fills the final framebuffer with the current template's background */
+int util_fillbg(struct show_t *show);
+/* util_fgcolor : returns the current template's foreground, white without one */
+struct pixel_t util_fgcolor(struct show_t *show);
 /* util_rect : utility function to fill out a rectangle */
 struct rect_t util_rect(s32 x, s32 y, s32 w, s32 h);
+/* util_assetpath : returns the path a fontadd / imageadd op loads, NULL for other ops */
+struct slice_t *util_assetpath(struct op_t *op);
+/* util_parsestat : reports how quickly the config file was parsed */
+void util_parsestat(size_t bytes, size_t commands, u64 ns);
+/* util_utf8decode : decodes 'len' bytes of utf-8 into dst (room for 'len' codepoints), returns how many it wrote */
+size_t util_utf8decode(u32 *dst, char *src, size_t len);
+/* util_utf8next : decodes one codepoint from the front of src, returns how many bytes it took */
+size_t util_utf8next(u32 *dst, u8 *src, size_t len);
 
 // Font Functions
 /* font_load : sets up an entry in the font table with these params */
-s32 font_load(struct font_t *font, char *name, char *path);
+s32 font_load(struct font_t *font, struct slice_t name, struct slice_t path);
+/* font_samefile : returns true if the font was loaded from the file 'path' / 'fileid' */
+int font_samefile(struct font_t *font, struct slice_t path, u64 *fileid);
+/* font_nameadd : gives the font at 'fontidx' the name 'name' */
+int font_nameadd(struct show_t *show, struct slice_t name, s32 fontidx);
 /* font_getfont : returns a pointer to the font structure with the matching name */
 struct font_t *font_getfont(struct show_t *show, char *name);
-/* font_getcodepoint : retrieves the fchar_t from input font and codepoint */
-struct fchar_t *font_getcodepoint(struct font_t *font, u32 codepoint, u32 fontsize);
+/* font_getcodepoint : retrieves the fchar_t from input font and codepoint, rasterizing in 'scratch' */
+struct fchar_t *font_getcodepoint(struct font_t *font, u32 codepoint, u32 fontsize, u32 mode, u32 subx, struct arena_t *scratch);
+/* font_getsdf : the miss path of font_getcodepoint, for GLYPHMODE_SDF */
+struct fchar_t *font_getsdf(struct font_t *font, u32 codepoint, u32 fontsize, struct arena_t *scratch);
+/* font_findcodepoint : looks for an already rendered codepoint, NULL if there isn't one */
+struct fchar_t *font_findcodepoint(struct font_t *font, u32 codepoint, u32 fontsize, u32 mode, u32 subx);
+/* font_insertcodepoint : adds a rendered codepoint to the font's table, with the write lock held */
+int font_insertcodepoint(struct font_t *font, struct fchar_t *fchar);
+/* font_atlasreserve : finds room for 'rect' in the atlas for 'fontsize', with the write lock held */
+struct atlaspage_t *font_atlasreserve(struct font_t *font, u32 fontsize, stbrp_rect *rect);
+/* font_atlaspage : adds a 'w' x 'h' page to the atlas, with the write lock held */
+struct atlaspage_t *font_atlaspage(struct font_t *font, struct atlas_t *atlas, s32 w, s32 h);
+/* font_glyphhash : hashes a (codepoint, fontsize, subx) triple */
+u64 font_glyphhash(u32 codepoint, u32 fontsize, u32 subx);
+/* font_glyph : returns the glyph for 'codepoint' in the show's current font size, at offset 'subx' */
+struct fchar_t *font_glyph(struct show_t *show, struct font_t *font, u32 codepoint, u32 subx);
+/* font_kernadd : adds the pair (a, b) to the font's kerning table, if it isn't already there */
+int font_kernadd(struct font_t *font, u32 a, u32 b);
+/* font_kern : returns the kerning between a and b at 'fontsize', in 26.6 fixed point */
+s32 font_kern(struct font_t *font, u32 a, u32 b, u32 fontsize);
+/* font_advance : returns how far 'codepoint' moves the pen at 'fontsize', in 26.6 fixed point */
+s32 font_advance(struct font_t *font, u32 codepoint, u32 fontsize);
+/* font_subpixel : splits the 26.6 pen position into a whole pixel 'x', returns the glyph offset to draw it with */
+u32 font_subpixel(s32 pen, s32 *x);
+/* font_report : prints glyph cache hit rates */
+void font_report(struct show_t *show);
+/* font_diskpath : puts the path of the font's on disk glyph cache in 'buf' */
+int font_diskpath(struct font_t *font, char *dir, char *buf, size_t len);
+/* font_diskload : maps in the font's on disk glyph cache, and adds its glyphs to the table */
+int font_diskload(struct font_t *font, char *dir);
+/* font_disksave : writes the font's glyph table out to its on disk glyph cache */
+int font_disksave(struct font_t *font, char *dir);
 /* font_free : frees all fonts associated with the slideshow */
 s32 font_free(struct show_t *show);
-/* font_vertadvance : returns the font's vertical advance */
-s32 font_vertadvance(struct font_t *font);
+/* font_fontfree : frees all resources associated with the font */
+int font_fontfree(struct font_t *font);
+/* font_vertadvance : returns the font's vertical advance at 'fontsize' */
+s32 font_vertadvance(struct font_t *font, u32 fontsize);
+/* font_scale : returns the scale that makes the font 'fontsize' pixels tall */
+f32 font_scale(struct font_t *font, u32 fontsize);
+/* font_metricsadd : adds the font's vertical metrics at 'fontsize' to its table, if they aren't already there */
+int font_metricsadd(struct font_t *font, u32 fontsize);
+/* font_metrics : returns the font's vertical metrics at 'fontsize', NULL if font_metricsadd never saw it */
+struct fmetrics_t *font_metrics(struct font_t *font, u32 fontsize);
 
 
 /* util_parsecolor : parses a color string into a color structure */
-struct color_t util_parsecolor(char *s);
+struct color_t util_parsecolor(struct slice_t s);
 
 /* m_lblend_u8 : linear blend on u8s */
 u8 m_lblend_u8(u8 a, u8 b, f32 t);
@@ -279,76 +824,76 @@ u8 m_lblend_u8(u8 a, u8 b, f32 t);
 int main(int argc, char **argv)
 {
 	struct show_t show;
-	s32 i, len;
+	char *config;
+	s32 jobs;
+	s32 usecache;
+	s32 prebake;
+	s32 watch;
+	char *glyphdir;
+	u32 glyphmode;
+	s32 i;
 	int rc;
-	char slidename[BUFSMALL];
-	char imagename[BUFSMALL];
 
-	if (argc < 2) {
-		fprintf(stderr, "USAGE : %s config\n", argv[0]);
+	config = NULL;
+	glyphdir = NULL;
+	glyphmode = GLYPHMODE_COVERAGE;
+	jobs = 1;
+	usecache = 1;
+	prebake = 0;
+	watch = 0;
+
+	for (i = 1; i < argc; i++) {
+		if (streq(argv[i], "-j") && i + 1 < argc) {
+			jobs = atoi(argv[++i]);
+		} else if (streq(argv[i], "--nocache")) {
+			usecache = 0;
+		} else if (streq(argv[i], "--prebake")) {
+			prebake = 1;
+		} else if (streq(argv[i], "--glyphcache") && i + 1 < argc) {
+			glyphdir = argv[++i];
+		} else if (streq(argv[i], "--sdf")) {
+			glyphmode = GLYPHMODE_SDF;
+		} else if (streq(argv[i], "--watch")) {
+			watch = 1;
+		} else {
+			config = argv[i];
+		}
+	}
+
+	if (!config || jobs < 1) {
+		fprintf(stderr, "USAGE : %s [-j jobs] [--nocache] [--prebake] [--glyphcache dir] [--sdf] [--watch] config\n", argv[0]);
 		exit(1);
 	}
 
-	memset(slidename, 0, sizeof slidename);
-	memset(imagename, 0, sizeof imagename);
+	// parse_printline decodes text with the ascii widener, so this goes before the show compiles
+	draw_init();
 
-	rc = show_load(&show, argv[1]);
+	rc = show_load(&show, config);
 	if (rc < 0) {
 		fprintf(stderr, "Couldn't load up the show!\n");
 		exit(1);
 	}
 
-	// hook up the default functions
-	functab_add(&show, "blank",        0, func_blank);
-	functab_add(&show, "name",         1, func_name);
-	functab_add(&show, "clear",        0, func_clear);
-	functab_add(&show, "newslide",     0, func_nop);
-	functab_add(&show, "templateadd",  1, func_templateadd);
-	functab_add(&show, "templateset",  0, func_templateset);
-	functab_add(&show, "dimensions",   1, func_dimensions);
-	functab_add(&show, "printline",    0, func_printline);
-	functab_add(&show, "printdate",    0, func_printdate);
-	functab_add(&show, "fontadd",      1, func_fontadd);
-	functab_add(&show, "fontset",      0, func_fontset);
-	functab_add(&show, "fontsizeset",  0, func_fontsizeset);
-	functab_add(&show, "imageadd",     1, func_imageadd);
-	functab_add(&show, "imagedraw",    0, func_imagedraw);
-
-	// exec all of the default functions
-	for (i = 0; i < show.commands_len; i++) {
-		s32 idx = util_getfuncidx(&show, show.commands[i].argv[0]);
-		if (idx < 0) {
-			ERR("Couldn't find function '%s'\n", show.commands[i].argv[0]);
-			continue;
-		}
-		if (show.functions[idx].run_once) {
-			rc = show.functions[idx].func(&show, show.commands[i].argc, show.commands[i].argv);
-		}
-	}
-
-	// setup the show's framebuffers and whatnot
-	util_framebuffer(&show);
-
-	for (i = 0, len = util_slidecount(&show); i < len; i++) {
-		snprintf(slidename, sizeof slidename, "%s_%04d", show.name, i);
-		snprintf(imagename, sizeof imagename, "%s.png", slidename);
+	show.glyphdir = glyphdir;
+	show.glyphmode = glyphmode;
 
-		printf("%s\n", imagename);
+	// hook up the default functions
+	functab_defaults(&show);
 
-		rc = show_render(&show, i);
-		if (rc < 0) {
-			fprintf(stderr, "Couldn't render '%s' to the image!\n", slidename);
-			exit(1);
-		}
+	// resolve every command, and exec all of the run once functions
+	rc = show_compile(&show);
+	if (rc < 0) {
+		fprintf(stderr, "Couldn't compile the show!\n");
+		exit(1);
+	}
 
-		rc = stbi_write_png(imagename, show.settings.img_w, show.settings.img_h,
-				sizeof(struct pixel_t), show.framebuffers[FRAMEBUFFER_FINAL],
-				sizeof(struct pixel_t) * show.settings.img_w);
+	rc = show_renderall(&show, jobs, usecache, prebake);
+	if (rc < 0 && !watch) {
+		exit(1);
+	}
 
-		if (!rc) {
-			fprintf(stderr, "Couldn't write %s!\n", imagename);
-			exit(1);
-		}
+	if (watch) {
+		show_watch(&show, config, jobs, prebake);
 	}
 
 	rc = show_free(&show);
@@ -363,71 +908,100 @@ int main(int argc, char **argv)
 /* show_load : load up the slideshow from the config file */
 int show_load(struct show_t *show, char *config)
 {
-	FILE *fp;
-	char *s;
-	s32 i;
-	s32 argc;
-	s32 len;
-	char *tokens[BUFSMALL];
-	char **argv;
-	char buf[BUFLARGE];
+	struct command_t *command;
+	struct slice_t *tokens;
+	char *s, *e, *eol, *end;
+	size_t first;
+	size_t i;
+	u64 start;
 
-	// TODO
-	// this would probably be better with tokenized strings
+	// NOTE (brian): the config file gets mapped in and scanned once. Every token is a slice of the
+	// mapping, so nothing gets copied, and lines can be as long as they like. Commands only hold
+	// the index of their first token until the scan is done, because the token array moves as it
+	// grows.
+	//
+	// Every line reserves a token in front of its own, for the `printline` that plain text lines
+	// turn into.
 
 	memset(show, 0, sizeof(*show));
 
-	fp = fopen(config, "r");
+	start = sys_nanotime();
 
-	if (!fp) {
+	show->src = sys_mapfile(config, &show->src_len);
+	if (!show->src) {
 		return -1;
 	}
 
-	while (buf == fgets(buf, sizeof buf, fp)) {
-		// trim the string to remove whitespace
-		s = rtrim(ltrim(buf));
+	end = show->src + show->src_len;
+
+	for (s = show->src; s < end; s = eol + 1) {
+		eol = memchr(s, '\n', end - s);
+		if (!eol) {
+			eol = end;
+		}
 
-		len = strlen(s);
+		// trim the line to remove whitespace
+		for (e = eol; s < e && isspace((unsigned char)*s); s++)
+			;
+		for (; s < e && isspace((unsigned char)e[-1]); e--)
+			;
 
-		if (len == 0) {
+		if (s == e) {
 			continue;
 		}
 
-		memset(tokens, 0, sizeof tokens);
+		first = show->tokens_len;
+
+		C_RESIZE(&show->tokens, &show->tokens, sizeof(*show->tokens));
+		show->tokens[show->tokens_len].s = "printline";
+		show->tokens[show->tokens_len].len = strlen("printline");
+		show->tokens_len++;
+
+		// split on spaces, a run of them counts as one
+		while (s < e) {
+			C_RESIZE(&show->tokens, &show->tokens, sizeof(*show->tokens));
+
+			show->tokens[show->tokens_len].s = s;
+			for (; s < e && *s != ' '; s++)
+				;
+			show->tokens[show->tokens_len].len = s - show->tokens[show->tokens_len].s;
+			show->tokens_len++;
 
-		for (i = 0, s = strtok(buf, " "); i < ARRSIZE(tokens) && s; i++, s = strtok(NULL, " ")) {
-			tokens[i] = s;
+			for (; s < e && *s == ' '; s++)
+				;
 		}
 
-		if (streq("//", tokens[0]) || streq("#", tokens[0])) {
+		tokens = show->tokens + first;
+
+		if (slice_eq(tokens[1], "//") || slice_eq(tokens[1], "#")) {
+			show->tokens_len = first;
 			continue;
 		}
 
-		if (!streq(":", tokens[0])) {
-			for (i = len - 1; i > -1; i--) {
-				tokens[i + 1] = tokens[i];
-			}
-			tokens[0] = "printline";
-			argv = tokens;
-		} else {
-			argv = tokens + 1;
+		if (slice_eq(tokens[1], ":")) {
+			first += 2;
 		}
 
-		for (argc = 0; argv[argc]; argc++)
-			;
+		if (first == show->tokens_len) {
+			continue;
+		}
 
 		C_RESIZE(&show->commands, &show->commands, sizeof(*show->commands));
 
-		show->commands[show->commands_len].argc = argc;
-		show->commands[show->commands_len].argv = calloc(argc, sizeof(char *));
-		for (i = 0; i < argc; i++) {
-			show->commands[show->commands_len].argv[i] = strdup(argv[i]);
-		}
+		command = show->commands + show->commands_len++;
 
-		show->commands_len++;
+		command->argc = show->tokens_len - first;
+		command->tok = first;
 	}
 
-	fclose(fp);
+	// the token array is done moving
+	for (i = 0; i < show->commands_len; i++) {
+		show->commands[i].argv = show->tokens + show->commands[i].tok;
+	}
+
+	util_slideindex(show);
+
+	util_parsestat(show->src_len, show->commands_len, sys_nanotime() - start);
 
 	return 0;
 }
@@ -435,99 +1009,1271 @@ int show_load(struct show_t *show, char *config)
 /* show_free : frees everything related to the slideshow */
 int show_free(struct show_t *show)
 {
+	s32 i;
+
+	assert(show);
+
+	functab_free(show);
+	font_free(show);
+
+	for (i = 0; i < ARRSIZE(show->framebuffers); i++) {
+		free(show->framebuffers[i]);
+	}
+
+	free(show->fontnames);
+	free(show->templates);
+	free(show->tokens);
+	free(show->commands);
+	free(show->ops);
+	free(show->slides);
+
+	sys_unmapfile(show->src, show->src_len);
+
+	// names, functions, parsed arguments, etc
+	arena_free(&show->arena);
+	arena_free(&show->scratch);
+
+	memset(show, 0, sizeof(*show));
+
 	return 0;
 }
 
-/* show_render : renders the slide 'idx' into its internal buffer */
-int show_render(struct show_t *show, s32 idx)
+/* show_compile : resolves and parses every command, running the run once commands */
+int show_compile(struct show_t *show)
 {
-	s32 cmdidx;
-	s32 i, slide;
-	s32 j;
+	struct op_t *op;
+	size_t i;
 	s32 rc;
-	struct rect_t dstdim, dstrect;
-	struct rect_t srcdim, srcrect;
 
-	// NOTE (brian) runs commands from `newslide` to `newslide`, combines framebuffers, then returns
+	// NOTE (brian): this happens in three passes. First, every command gets its function looked up,
+	// so unknown commands get reported exactly once. Then, the run once commands (fonts, templates,
+	// dimensions, etc) are parsed and run, in order. Finally, the arguments of everything else are
+	// parsed; this has to come last so font and template names can be turned into indices.
+	//
+	// show_render then only ever has to call op->function->func.
 
 	assert(show);
 
-	for (i = 0, slide = -1; i < show->commands_len && slide < idx; i++) {
-		if (streq(show->commands[i].argv[0], "newslide")) {
-			slide++;
+	show->ops_len = 0;
+
+	for (i = 0; i < show->commands_len; i++) {
+		C_RESIZE(&show->ops, &show->ops, sizeof(*show->ops));
+
+		op = show->ops + show->ops_len++;
+
+		memset(op, 0, sizeof(*op));
+
+		op->argc = show->commands[i].argc;
+		op->argv = show->commands[i].argv;
+
+		op->function = functab_get(show, op->argv[0].s, op->argv[0].len);
+		if (!op->function) {
+			ERR("Couldn't find function '%.*s'\n", SLICE_ARG(op->argv[0]));
 		}
 	}
 
-	cmdidx = i;
+	for (i = 0; i < show->ops_len; i++) {
+		op = show->ops + i;
 
-	for (i = cmdidx; i < show->commands_len && !streq(show->commands[i].argv[0], "newslide"); i++) {
-		j = util_getfuncidx(show, show->commands[i].argv[0]);
-		if (j < 0) {
-			ERR("Function '%s' doesn't exist!\n", show->commands[i].argv[0]);
+		if (!op->function || !op->function->run_once) {
 			continue;
 		}
 
-		printf("Execing '%s'\n", show->functions[j].name);
+		if (op->function->parse && op->function->parse(show, op) < 0) {
+			ERR("Couldn't parse arguments for '%.*s'\n", SLICE_ARG(op->argv[0]));
+			op->function = NULL;
+			continue;
+		}
 
-		rc = show->functions[j].func(show, show->commands[i].argc, show->commands[i].argv);
+		rc = op->function->func(show, op);
 		if (rc < 0) {
-			ERR("Function '%s' returned with an error!\n", show->commands[i].argv[0]);
+			ERR("Function '%.*s' returned with an error!\n", SLICE_ARG(op->argv[0]));
 		}
 	}
 
-	dstdim = util_rect(0, 0, show->settings.img_w, show->settings.img_h);
-	srcdim = util_rect(0, 0, show->settings.img_w, show->settings.img_h);
-	dstrect = dstdim;
-	srcrect = srcdim;
+	for (i = 0; i < show->ops_len; i++) {
+		op = show->ops + i;
 
-	// draw_rect(show->framebuffers[FRAMEBUFFER_FINAL], show->framebuffers[FRAMEBUFFER_BACKGROUND], dstdim, srcdim, dstrect, srcrect, 0);
-	// draw_rect(show->framebuffers[FRAMEBUFFER_FINAL], show->framebuffers[FRAMEBUFFER_BACKGROUND], dstdim, srcdim, dstrect, srcrect);
+		if (!op->function || op->function->run_once || !op->function->parse) {
+			continue;
+		}
 
-	/*
-	for (i = 1; i < ARRSIZE(show->framebuffers); i++) {
-		draw_rect(show->framebuffers[FRAMEBUFFER_FINAL], show->framebuffers[i], dstdim, srcdim, dstrect, srcrect);
+		if (op->function->parse(show, op) < 0) {
+			ERR("Couldn't parse arguments for '%.*s'\n", SLICE_ARG(op->argv[0]));
+			op->function = NULL;
+		}
 	}
-	*/
 
-	return 0;
+	return show_snapshot(show);
 }
 
-#if 0
-
-/* show_renderimage : renders the image to the slide */
-int show_renderimage(struct show_t *show, struct image_t *image, s32 x, s32 y)
+/* show_snapshot : records the settings every slide starts with, without rendering anything */
+int show_snapshot(struct show_t *show)
 {
-	struct pixel_t *iscaled; // image scaled
-	s32 bound_x, bound_y, bound_w, bound_h;
-	s32 img_w, img_h, win_w, win_h;
-	s32 i, j, dst, src;
-	f32 scale;
-	int rc;
+	struct settings_t settings;
+	struct font_t *font;
+	struct op_t *op;
+	size_t i, j, k;
+	u32 *text;
 
-	// NOTE (brian)
-	// Before we even attempt to render the image to the window, we have to
-	// determine where in X and Y we can actually fit the image onto the screen.
+	// NOTE (brian): walks the show in order, running only the 'state' side of every op, and saves
+	// show->settings at every slide boundary. show_render restores that snapshot before it runs a
+	// slide, so slides can be rendered alone, and in any order.
 	//
-	// We do this by determining the dimensions it has to fit in, then calling
-	// stbir_resize_uint8 on those dimensions, then copying it to the image.
+	// It's also where every font gets the metrics of every size it prints at, and the kerning of
+	// every pair of codepoints it prints next to each other, since this is the one walk that sees
+	// every printline before the slide workers do. Both go in before the op's state runs, so
+	// state_printline wraps the line exactly like func_printline will.
+	//
+	// stbtt_GetCodepointKernAdvance searches the font's kern (or GPOS) table every time it's
+	// called, so it's called once per pair, and printline only does a hash lookup. In watch mode
+	// the tables come along with the fonts, and just gain whatever pairs are new.
 
-	img_w = image->img_w;
-	img_h = image->img_h;
-	win_w = show->settings.img_w;
-	win_h = show->settings.img_h;
+	assert(show);
 
-	scale = 1.0f;
+	settings = show->settings;
 
-	if (win_w < img_w) {
-		scale = (f32)win_w / img_w;
-	}
+	for (i = 0; i < show->slides_len; i++) {
+		show->settings.slide = i;
+		show->slides[i].entry = show->settings;
 
-	if (win_h < img_h) {
-		scale = (f32)win_h / img_h;
+		for (j = show->slides[i].start; j < show->slides[i].end; j++) {
+			op = show->ops + j;
+
+			if (op->function && op->function->func == func_printline && 0 <= show->settings.fontidx &&
+					show->settings.fontidx < show->fonts_len && 0 < show->settings.fontsize) {
+				font = show->fonts + show->settings.fontidx;
+				text = op->args.text;
+
+				if (font_metricsadd(font, show->settings.fontsize) < 0) {
+					return -1;
+				}
+
+				for (k = 1; k < op->args.text_len; k++) {
+					if (text[k - 1] != ' ' && text[k] != ' ' && font_kernadd(font, text[k - 1], text[k]) < 0) {
+						return -1;
+					}
+				}
+			}
+
+			if (op->function && !op->function->run_once && op->function->state) {
+				op->function->state(show, op);
+			}
+		}
 	}
 
-	img_w *= scale;
-	img_h *= scale;
+	show->settings = settings;
+
+	return 0;
+}
+
+/* show_render : renders the slide 'idx' into its internal buffer */
+int show_render(struct show_t *show, s32 idx)
+{
+	struct slide_t *slide;
+	struct op_t *op;
+	s32 i;
+	s32 rc;
+	struct rect_t dstdim, dstrect;
+	struct rect_t srcdim, srcrect;
+
+	// NOTE (brian) runs commands from `newslide` to `newslide`, combines framebuffers, then returns
+
+	assert(show);
+
+	if (idx < 0 || show->slides_len <= idx) {
+		return -1;
+	}
+
+	slide = show->slides + idx;
+
+	// nothing from the last slide's scratch memory is still in use
+	arena_reset(&show->scratch);
+
+	// every slide starts from its snapshot, on a fresh background
+	show->settings = slide->entry;
+
+	util_fillbg(show);
+
+	for (i = slide->start; i < slide->end; i++) {
+		op = show->ops + i;
+
+		// unknown commands were already reported by show_compile
+		if (!op->function || op->function->run_once) {
+			continue;
+		}
+
+		rc = op->function->func(show, op);
+		if (rc < 0) {
+			ERR("Function '%.*s' returned with an error!\n", SLICE_ARG(op->argv[0]));
+		}
+	}
+
+	dstdim = util_rect(0, 0, show->settings.img_w, show->settings.img_h);
+	srcdim = util_rect(0, 0, show->settings.img_w, show->settings.img_h);
+	dstrect = dstdim;
+	srcrect = srcdim;
+
+	// draw_rect(show->framebuffers[FRAMEBUFFER_FINAL], show->framebuffers[FRAMEBUFFER_BACKGROUND], dstdim, srcdim, dstrect, srcrect, 0);
+	// draw_rect(show->framebuffers[FRAMEBUFFER_FINAL], show->framebuffers[FRAMEBUFFER_BACKGROUND], dstdim, srcdim, dstrect, srcrect);
+
+	/*
+	for (i = 1; i < ARRSIZE(show->framebuffers); i++) {
+		draw_rect(show->framebuffers[FRAMEBUFFER_FINAL], show->framebuffers[i], dstdim, srcdim, dstrect, srcrect);
+	}
+	*/
+
+	return 0;
+}
+
+/* show_renderall : renders every slide that isn't cached, on 'jobs' threads */
+int show_renderall(struct show_t *show, s32 jobs, s32 usecache, s32 prebake)
+{
+	struct pipeline_t pipeline;
+	struct worker_t *workers;
+	struct pixel_t *pixels;
+	size_t bytes;
+	s32 nframes, nworkers;
+	s32 i, j;
+	u64 start;
+
+	// NOTE (brian): slides go through three stages, linked by bounded queues:
+	//
+	//   render (jobs threads) -> encode (jobs threads) -> write (one thread)
+	//
+	// Renderers draw into framebuffers taken from a fixed pool ('free'), so they stall once the
+	// encoders fall behind, and framebuffer memory never goes past 'nframes' of them. Encoders turn
+	// the pixels into a png in memory and hand the framebuffer right back. The writer only touches
+	// the disk. Every slide renders from its own snapshot (see show_snapshot), so the order slides
+	// come out in doesn't matter, and the pngs are the same for any number of jobs.
+	//
+	// Slides whose png on disk was made from the same cache key never go into the pipeline at all.
+	// With 'prebake', every glyph the rest of them print gets rasterized up front, so rendering is
+	// only ever blitting.
+
+	assert(show);
+
+	memset(&pipeline, 0, sizeof pipeline);
+
+	pipeline.show = show;
+
+	for (i = 0; i < show->slides_len; i++) {
+		show->slides[i].key = cache_slidekey(show, i);
+		show->slides[i].fresh = 0;
+	}
+
+	if (usecache) {
+		cache_load(show);
+	}
+
+	pipeline.todo = calloc(MAX(show->slides_len, 1), sizeof(*pipeline.todo));
+	if (!pipeline.todo) {
+		return -1;
+	}
+
+	for (i = 0; i < show->slides_len; i++) {
+		if (!show->slides[i].fresh) {
+			pipeline.todo[pipeline.todo_len++] = i;
+		}
+	}
+
+	fprintf(stderr, "%zu of %zu slides cached\n", show->slides_len - pipeline.todo_len, show->slides_len);
+
+	if (prebake) {
+		show_prebake(show, pipeline.todo, pipeline.todo_len, jobs);
+	}
+
+	nframes = 2 * jobs + 1;
+	bytes = (size_t)show->settings.img_w * show->settings.img_h * sizeof(struct pixel_t);
+
+	queue_init(&pipeline.free, nframes);
+	queue_init(&pipeline.encode, nframes);
+	queue_init(&pipeline.write, nframes);
+
+	for (i = 0; i < nframes; i++) {
+		pixels = malloc(bytes);
+		if (!pixels) {
+			return -1;
+		}
+		queue_push(&pipeline.free, pixels);
+	}
+
+	pipeline.stages[STAGE_RENDER].name = "render";
+	pipeline.stages[STAGE_RENDER].threads = jobs;
+	pipeline.stages[STAGE_ENCODE].name = "encode";
+	pipeline.stages[STAGE_ENCODE].threads = jobs;
+	pipeline.stages[STAGE_WRITE].name = "write";
+	pipeline.stages[STAGE_WRITE].threads = 1;
+
+	for (i = 0, nworkers = 0; i < STAGE_TOTAL; i++) {
+		pipeline.stages[i].active = pipeline.stages[i].threads;
+		nworkers += pipeline.stages[i].threads;
+	}
+
+	workers = calloc(nworkers, sizeof(*workers));
+	if (!workers) {
+		return -1;
+	}
+
+	start = sys_nanotime();
+
+	for (i = 0, j = 0; i < nworkers; i++) {
+		workers[i].pipeline = &pipeline;
+
+		if (i < jobs) {
+			// renderers get their own shallow copy of the show, and their own scratch arena
+			workers[i].show = *show;
+
+			memset(&workers[i].show.scratch, 0, sizeof(workers[i].show.scratch));
+			memset(&workers[i].show.glyphs, 0, sizeof(workers[i].show.glyphs));
+
+			for (j = 0; j < ARRSIZE(workers[i].show.framebuffers); j++) {
+				workers[i].show.framebuffers[j] = NULL;
+			}
+
+			util_framebuffer(&workers[i].show);
+
+			pthread_create(&workers[i].thread, NULL, pipeline_render, workers + i);
+		} else if (i < 2 * jobs) {
+			pthread_create(&workers[i].thread, NULL, pipeline_encode, workers + i);
+		} else {
+			pthread_create(&workers[i].thread, NULL, pipeline_write, workers + i);
+		}
+	}
+
+	for (i = 0; i < nworkers; i++) {
+		pthread_join(workers[i].thread, NULL);
+
+		if (i < jobs) {
+			for (j = 0; j < ARRSIZE(workers[i].show.framebuffers); j++) {
+				free(workers[i].show.framebuffers[j]);
+			}
+
+			arena_free(&workers[i].show.scratch);
+
+			show->glyphs.hits += workers[i].show.glyphs.hits;
+		}
+	}
+
+	pipeline_report(&pipeline, sys_nanotime() - start);
+	font_report(show);
+
+	for (i = 0; show->glyphdir && i < show->fonts_len; i++) {
+		font_disksave(show->fonts + i, show->glyphdir);
+	}
+
+	queue_close(&pipeline.free);
+
+	while ((pixels = queue_pop(&pipeline.free)) != NULL) {
+		free(pixels);
+	}
+
+	queue_free(&pipeline.free);
+	queue_free(&pipeline.encode);
+	queue_free(&pipeline.write);
+
+	free(workers);
+	free(pipeline.todo);
+
+	cache_save(show);
+
+	return pipeline.rc;
+}
+
+/* pipeline_render : render stage, takes slides off the shared counter until they're gone */
+void *pipeline_render(void *arg)
+{
+	struct worker_t *worker;
+	struct pipeline_t *pipeline;
+	struct stage_t *stage;
+	struct frame_t *frame;
+	struct pixel_t *pixels;
+	s32 idx;
+	u64 start;
+
+	worker = arg;
+	pipeline = worker->pipeline;
+	stage = pipeline->stages + STAGE_RENDER;
+
+	// we draw straight into the pooled framebuffers, never our own final one
+	free(worker->show.framebuffers[FRAMEBUFFER_FINAL]);
+
+	for (;;) {
+		idx = __atomic_fetch_add(&pipeline->next, 1, __ATOMIC_RELAXED);
+		if (pipeline->todo_len <= idx) {
+			break;
+		}
+
+		idx = pipeline->todo[idx];
+
+		pixels = queue_pop(&pipeline->free);
+
+		start = sys_nanotime();
+
+		worker->show.framebuffers[FRAMEBUFFER_FINAL] = pixels;
+
+		if (show_render(&worker->show, idx) < 0) {
+			fprintf(stderr, "Couldn't render slide %d!\n", idx);
+			pipeline->rc = -1;
+			queue_push(&pipeline->free, pixels);
+			continue;
+		}
+
+		frame = calloc(1, sizeof(*frame));
+		assert(frame);
+
+		frame->idx = idx;
+		frame->pixels = pixels;
+
+		pipeline_stat(stage, sys_nanotime() - start);
+
+		queue_push(&pipeline->encode, frame);
+	}
+
+	worker->show.framebuffers[FRAMEBUFFER_FINAL] = NULL;
+
+	// the last renderer out lets the encoders know there's nothing else coming
+	if (__atomic_sub_fetch(&stage->active, 1, __ATOMIC_ACQ_REL) == 0) {
+		queue_close(&pipeline->encode);
+	}
+
+	return NULL;
+}
+
+/* pipeline_encode : encode stage, turns rendered framebuffers into pngs in memory */
+void *pipeline_encode(void *arg)
+{
+	struct worker_t *worker;
+	struct pipeline_t *pipeline;
+	struct stage_t *stage;
+	struct frame_t *frame;
+	struct show_t *show;
+	u64 start;
+
+	worker = arg;
+	pipeline = worker->pipeline;
+	stage = pipeline->stages + STAGE_ENCODE;
+	show = pipeline->show;
+
+	while ((frame = queue_pop(&pipeline->encode)) != NULL) {
+		start = sys_nanotime();
+
+		frame->png = stbi_write_png_to_mem((u8 *)frame->pixels, sizeof(struct pixel_t) * show->settings.img_w,
+				show->settings.img_w, show->settings.img_h, sizeof(struct pixel_t), &frame->png_len);
+
+		pipeline_stat(stage, sys_nanotime() - start);
+
+		queue_push(&pipeline->free, frame->pixels);
+		frame->pixels = NULL;
+
+		queue_push(&pipeline->write, frame);
+	}
+
+	if (__atomic_sub_fetch(&stage->active, 1, __ATOMIC_ACQ_REL) == 0) {
+		queue_close(&pipeline->write);
+	}
+
+	return NULL;
+}
+
+/* pipeline_write : write stage, puts the encoded pngs on disk */
+void *pipeline_write(void *arg)
+{
+	struct worker_t *worker;
+	struct pipeline_t *pipeline;
+	struct stage_t *stage;
+	struct frame_t *frame;
+	char imagename[BUFSMALL + 16];
+	FILE *fp;
+	u64 start;
+
+	worker = arg;
+	pipeline = worker->pipeline;
+	stage = pipeline->stages + STAGE_WRITE;
+
+	while ((frame = queue_pop(&pipeline->write)) != NULL) {
+		start = sys_nanotime();
+
+		snprintf(imagename, sizeof imagename, "%s_%04d.png", pipeline->show->name, frame->idx);
+
+		printf("%s\n", imagename);
+
+		fp = frame->png ? fopen(imagename, "wb") : NULL;
+		if (!fp || fwrite(frame->png, 1, frame->png_len, fp) != frame->png_len) {
+			fprintf(stderr, "Couldn't write %s!\n", imagename);
+			pipeline->rc = -1;
+		} else {
+			pipeline->show->slides[frame->idx].fresh = 1;
+		}
+
+		if (fp) {
+			fclose(fp);
+		}
+
+		pipeline_stat(stage, sys_nanotime() - start);
+
+		free(frame->png);
+		free(frame);
+	}
+
+	return NULL;
+}
+
+/* pipeline_stat : counts one item through the stage, that took 'ns' nanoseconds */
+void pipeline_stat(struct stage_t *stage, u64 ns)
+{
+	__atomic_add_fetch(&stage->items, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&stage->busy, ns, __ATOMIC_RELAXED);
+}
+
+/* pipeline_report : prints per stage throughput and queue occupancy */
+void pipeline_report(struct pipeline_t *pipeline, u64 wall)
+{
+	struct stage_t *stage;
+	struct queue_t *queue;
+	struct queue_t *queues[3];
+	char *names[3];
+	f64 busy, secs;
+	s32 i;
+
+	secs = wall / 1e9;
+
+	fprintf(stderr, "%-8s %8s %8s %10s %12s\n", "stage", "threads", "slides", "busy (s)", "slides/s");
+
+	for (i = 0; i < STAGE_TOTAL; i++) {
+		stage = pipeline->stages + i;
+		busy = stage->busy / 1e9;
+
+		// throughput is per thread busy time, what the stage could do if it never waited
+		fprintf(stderr, "%-8s %8d %8llu %10.3f %12.1f\n", stage->name, stage->threads, stage->items, busy,
+				busy > 0 ? stage->items * stage->threads / busy : 0.0);
+	}
+
+	queues[0] = &pipeline->free;   names[0] = "free";
+	queues[1] = &pipeline->encode; names[1] = "encode";
+	queues[2] = &pipeline->write;  names[2] = "write";
+
+	fprintf(stderr, "%-8s %8s %8s %10s\n", "queue", "cap", "max", "avg");
+
+	for (i = 0; i < ARRSIZE(queues); i++) {
+		queue = queues[i];
+		fprintf(stderr, "%-8s %8zu %8zu %10.2f\n", names[i], queue->cap, queue->maxlen,
+				queue->pushes ? (f64)queue->occupancy / queue->pushes : 0.0);
+	}
+
+	fprintf(stderr, "%llu slides in %.3fs (%.1f slides/s)\n", pipeline->stages[STAGE_WRITE].items, secs,
+			secs > 0 ? pipeline->stages[STAGE_WRITE].items / secs : 0.0);
+}
+
+//
+// Watch Mode Functions
+//
+
+#if defined(__linux__)
+
+/* show_watch : re-renders whatever changes, whenever the show or anything it loads changes */
+int show_watch(struct show_t *show, char *config, s32 jobs, s32 prebake)
+{
+	struct watch_t *watches;
+	struct show_t next;
+	char buf[BUFLARGE] __attribute__((aligned(__alignof__(struct inotify_event))));
+	struct inotify_event *event;
+	struct pollfd pfd;
+	size_t watches_len;
+	size_t i;
+	ssize_t n;
+	char *p;
+	s32 changed;
+	s32 fd;
+	s32 rc;
+	u64 start;
+
+	// NOTE (brian): we watch the directories the files live in, rather than the files themselves,
+	// because most editors save by writing a new file and renaming it over the old one, which
+	// would orphan a watch on the file.
+	//
+	// When something changes, the show gets loaded and compiled again from scratch, but fonts that
+	// didn't change are handed over from the old show (with their glyph caches). Then the render
+	// cache does the diffing: only slides whose cache key changed get rendered again.
+
+	assert(show);
+
+	fd = inotify_init1(IN_CLOEXEC);
+	if (fd < 0) {
+		ERR("Couldn't start inotify\n");
+		return -1;
+	}
+
+	watches = NULL;
+	watches_len = 0;
+
+	watch_add(fd, &watches, &watches_len, show, config);
+
+	fprintf(stderr, "watching %zu files for changes...\n", watches_len);
+
+	for (;;) {
+		changed = 0;
+
+		for (i = 0; i < watches_len; i++) {
+			watches[i].changed = 0;
+		}
+
+		// block for the first event, then keep draining until things go quiet for a bit
+		pfd.fd = fd;
+		pfd.events = POLLIN;
+
+		for (rc = poll(&pfd, 1, -1); 0 < rc; rc = poll(&pfd, 1, WATCH_DEBOUNCE)) {
+			n = read(fd, buf, sizeof buf);
+			if (n <= 0) {
+				break;
+			}
+
+			if (!changed) {
+				start = sys_nanotime();
+			}
+
+			for (p = buf; p < buf + n; p += sizeof(struct inotify_event) + event->len) {
+				event = (struct inotify_event *)p;
+
+				for (i = 0; event->len && i < watches_len; i++) {
+					if (watches[i].wd == event->wd && streq(watches[i].base, event->name)) {
+						watches[i].changed = 1;
+						changed = 1;
+					}
+				}
+			}
+		}
+
+		if (!changed) {
+			continue;
+		}
+
+		// fonts that changed on disk can't be handed over
+		for (i = 0; i < show->fonts_len; i++) {
+			show->fonts[i].stale = watch_changed(watches, watches_len, show->fonts[i].path);
+		}
+
+		for (i = 0; i < watches_len; i++) {
+			if (watches[i].changed) {
+				fprintf(stderr, "%s changed\n", watches[i].path);
+			}
+		}
+
+		rc = show_load(&next, config);
+		if (rc < 0) {
+			ERR("Couldn't load up the show, keeping the old one!\n");
+			continue;
+		}
+
+		next.glyphdir = show->glyphdir;
+		next.glyphmode = show->glyphmode;
+
+		next.oldfonts = show->fonts;
+		next.oldfonts_len = show->fonts_len;
+
+		functab_defaults(&next);
+
+		// NOTE (brian): by now, next may have taken fonts over from the old show, so it replaces the old
+		// show even if it doesn't compile
+		rc = show_compile(&next);
+		if (rc < 0) {
+			ERR("Couldn't compile the show!\n");
+		} else {
+			rc = show_renderall(&next, jobs, 1, prebake);
+			fprintf(stderr, "edit to png latency: %.1fms\n", (sys_nanotime() - start) / 1e6);
+		}
+
+		next.oldfonts = NULL;
+		next.oldfonts_len = 0;
+
+		show_free(show);
+		*show = next;
+
+		// the show might load different files now
+		watch_free(watches, watches_len);
+
+		watches = NULL;
+		watches_len = 0;
+
+		watch_add(fd, &watches, &watches_len, show, config);
+
+		fprintf(stderr, "watching %zu files for changes...\n", watches_len);
+	}
+
+	watch_free(watches, watches_len);
+
+	close(fd);
+
+	return 0;
+}
+
+/* watch_add : watches the config file, and every file the show loads */
+int watch_add(s32 fd, struct watch_t **watches, size_t *watches_len, struct show_t *show, char *config)
+{
+	char *path;
+	size_t i;
+
+	// NOTE (brian): the config file is always watches[0]
+
+	*watches = calloc(show->ops_len + 1, sizeof(**watches));
+	*watches_len = 0;
+
+	watch_file(fd, *watches, watches_len, config);
+
+	for (i = 0; i < show->ops_len; i++) {
+		if (util_assetpath(show->ops + i)) {
+			path = slice_dup(*util_assetpath(show->ops + i));
+			watch_file(fd, *watches, watches_len, path);
+			free(path);
+		}
+	}
+
+	return 0;
+}
+
+/* watch_file : adds a watch on the directory 'path' lives in, for changes to 'path' */
+int watch_file(s32 fd, struct watch_t *watches, size_t *watches_len, char *path)
+{
+	struct watch_t *watch;
+	char *dir;
+	char *base;
+
+	watch = watches + *watches_len;
+
+	dir = strdup(path);
+
+	base = strrchr(dir, '/');
+	if (base) {
+		*base++ = 0;
+		watch->wd = inotify_add_watch(fd, *dir ? dir : "/", IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+	} else {
+		base = dir;
+		watch->wd = inotify_add_watch(fd, ".", IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+	}
+
+	if (watch->wd < 0) {
+		ERR("Couldn't watch '%s'\n", path);
+		free(dir);
+		return -1;
+	}
+
+	watch->path = strdup(path);
+	watch->base = strdup(base);
+	watch->changed = 0;
+
+	free(dir);
+
+	(*watches_len)++;
+
+	return 0;
+}
+
+/* watch_changed : returns true if the file at 'path' was seen changing */
+s32 watch_changed(struct watch_t *watches, size_t watches_len, char *path)
+{
+	size_t i;
+
+	for (i = 0; i < watches_len; i++) {
+		if (watches[i].changed && streq(watches[i].path, path)) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/* watch_free : frees the watch list */
+void watch_free(struct watch_t *watches, size_t watches_len)
+{
+	size_t i;
+
+	for (i = 0; i < watches_len; i++) {
+		free(watches[i].path);
+		free(watches[i].base);
+	}
+
+	free(watches);
+}
+
+#else
+
+/* show_watch : re-renders whatever changes, whenever the show or anything it loads changes */
+int show_watch(struct show_t *show, char *config, s32 jobs, s32 prebake)
+{
+	ERR("--watch needs inotify, which this platform doesn't have\n");
+	return -1;
+}
+
+#endif
+
+//
+// Render Cache Functions
+//
+
+/* cache_slidekey : hashes everything the slide's pixels depend on */
+u64 cache_slidekey(struct show_t *show, s32 idx)
+{
+	struct slide_t *slide;
+	struct op_t *op;
+	struct font_t *font;
+	struct template_t *template;
+	size_t i;
+	s32 j;
+	u64 key;
+
+	// NOTE (brian): the key covers the slide's commands (as written), the settings it starts with
+	// (which has the output dimensions in it), and whatever fonts and templates it can see: the
+	// entry font and template, plus any it switches to. Fonts only put in their file's content hash;
+	// the metrics at each size come from the font itself (font_metricsadd), so the hash covers them.
+
+	assert(show);
+
+	slide = show->slides + idx;
+
+	key = c_hash(BSLIDES_CACHEVERSION, strlen(BSLIDES_CACHEVERSION), C_HASHSEED);
+	key = c_hash(&show->glyphmode, sizeof show->glyphmode, key);
+	key = c_hash(&slide->entry, sizeof slide->entry, key);
+
+	for (i = slide->start; i < slide->end; i++) {
+		op = show->ops + i;
+
+		for (j = 0; j < op->argc; j++) {
+			key = c_hash(&op->argv[j].len, sizeof op->argv[j].len, key);
+			key = c_hash(op->argv[j].s, op->argv[j].len, key);
+		}
+	}
+
+	for (i = slide->start - 1; i < slide->end; i++) {
+		op = show->ops + i;
+
+		// the `newslide` itself stands in for the entry font and template
+		if (i == slide->start - 1) {
+			font = cache_font(show, slide->entry.fontidx);
+			template = cache_template(show, slide->entry.template);
+		} else if (op->function && op->function->func == func_fontset) {
+			font = cache_font(show, op->args.i[0]);
+			template = NULL;
+		} else if (op->function && op->function->func == func_templateset) {
+			font = NULL;
+			template = cache_template(show, op->args.i[0]);
+		} else {
+			continue;
+		}
+
+		if (font) {
+			key = c_hash(&font->hash, sizeof font->hash, key);
+		}
+
+		if (template) {
+			key = c_hash(&template->justification, sizeof template->justification, key);
+			key = c_hash(&template->fg, sizeof template->fg, key);
+			key = c_hash(&template->bg, sizeof template->bg, key);
+		}
+	}
+
+	return key;
+}
+
+/* cache_font : returns the font at 'idx', NULL if it doesn't exist */
+struct font_t *cache_font(struct show_t *show, s32 idx)
+{
+	return 0 <= idx && idx < show->fonts_len ? show->fonts + idx : NULL;
+}
+
+/* cache_template : returns the template at 'idx', NULL if it doesn't exist */
+struct template_t *cache_template(struct show_t *show, s32 idx)
+{
+	return 0 <= idx && idx < show->templates_len ? show->templates + idx : NULL;
+}
+
+/* cache_load : marks every slide whose png on disk matches its key in the sidecar file as fresh */
+int cache_load(struct show_t *show)
+{
+	char path[BUFSMALL + 16];
+	char imagename[BUFSMALL + 16];
+	FILE *fp;
+	s32 idx;
+	u64 key;
+
+	assert(show);
+
+	snprintf(path, sizeof path, "%s.bscache", show->name);
+
+	fp = fopen(path, "r");
+	if (!fp) {
+		return 0;
+	}
+
+	while (fscanf(fp, "%d %llx", &idx, &key) == 2) {
+		if (idx < 0 || show->slides_len <= idx || show->slides[idx].key != key) {
+			continue;
+		}
+
+		// the key only counts if the png is still there
+		snprintf(imagename, sizeof imagename, "%s_%04d.png", show->name, idx);
+		if (access(imagename, F_OK) == 0) {
+			show->slides[idx].fresh = 1;
+		}
+	}
+
+	fclose(fp);
+
+	return 0;
+}
+
+/* cache_save : writes the key of every fresh slide out to the sidecar file */
+int cache_save(struct show_t *show)
+{
+	char path[BUFSMALL + 16];
+	FILE *fp;
+	size_t i;
+
+	assert(show);
+
+	snprintf(path, sizeof path, "%s.bscache", show->name);
+
+	fp = fopen(path, "w");
+	if (!fp) {
+		ERR("Couldn't write the render cache '%s'\n", path);
+		return -1;
+	}
+
+	for (i = 0; i < show->slides_len; i++) {
+		if (show->slides[i].fresh) {
+			fprintf(fp, "%04zu %016llx\n", i, show->slides[i].key);
+		}
+	}
+
+	fclose(fp);
+
+	return 0;
+}
+
+//
+// Prebake Functions
+//
+
+/* show_prebake : rasterizes every glyph the 'todo' slides print, on 'jobs' threads */
+int show_prebake(struct show_t *show, s32 *todo, s32 todo_len, s32 jobs)
+{
+	struct prebake_t prebake;
+	struct bakeworker_t *workers;
+	struct settings_t settings;
+	size_t bakes_cap;
+	size_t i, j;
+	u64 start;
+
+	// NOTE (brian): every slide gets walked from its snapshot, running only the 'state' side of its
+	// ops, like show_snapshot does, to see what font and size each printline ends up with. The
+	// glyphs get deduplicated, then split over the workers, who put them into the fonts' tables the
+	// same way a miss during rendering would.
+
+	assert(show);
+
+	start = sys_nanotime();
+
+	memset(&prebake, 0, sizeof prebake);
+
+	prebake.show = show;
+
+	settings = show->settings;
+	bakes_cap = 0;
+
+	for (i = 0; i < todo_len; i++) {
+		prebake_collect(show, todo[i], &prebake.bakes, &prebake.bakes_len, &bakes_cap);
+	}
+
+	show->settings = settings;
+
+	if (prebake.bakes_len) {
+		qsort(prebake.bakes, prebake.bakes_len, sizeof(*prebake.bakes), prebake_cmp);
+	}
+
+	for (i = 0, j = 0; i < prebake.bakes_len; i++) {
+		if (j == 0 || prebake_cmp(prebake.bakes + j - 1, prebake.bakes + i) != 0) {
+			prebake.bakes[j++] = prebake.bakes[i];
+		}
+	}
+
+	prebake.bakes_len = j;
+
+	workers = calloc(jobs, sizeof(*workers));
+	if (!workers) {
+		free(prebake.bakes);
+		return -1;
+	}
+
+	for (i = 0; i < jobs; i++) {
+		workers[i].prebake = &prebake;
+		pthread_create(&workers[i].thread, NULL, prebake_worker, workers + i);
+	}
+
+	for (i = 0; i < jobs; i++) {
+		pthread_join(workers[i].thread, NULL);
+		arena_free(&workers[i].scratch);
+	}
+
+	fprintf(stderr, "prebaked %zu glyphs on %d threads in %.1fms\n", prebake.bakes_len, jobs,
+			(sys_nanotime() - start) / 1e6);
+
+	free(workers);
+	free(prebake.bakes);
+
+	return 0;
+}
+
+/* prebake_collect : adds every glyph slide 'idx' prints to the list */
+int prebake_collect(struct show_t *show, s32 idx, struct bake_t **bakes, size_t *bakes_len, size_t *bakes_cap)
+{
+	struct slide_t *slide;
+	struct op_t *op;
+	struct bake_t *bake;
+	struct font_t *font;
+	struct layout_t layout;
+	size_t i, j;
+	s32 x;
+
+	slide = show->slides + idx;
+
+	show->settings = slide->entry;
+
+	for (i = slide->start; i < slide->end; i++) {
+		op = show->ops + i;
+
+		if (!op->function || op->function->run_once) {
+			continue;
+		}
+
+		if (op->function->func == func_printline && 0 <= show->settings.fontidx &&
+				show->settings.fontidx < show->fonts_len && 0 < show->settings.fontsize) {
+			font = show->fonts + show->settings.fontidx;
+
+			// the same layout func_printline draws, so the glyphs get baked at the offsets they'll
+			// be drawn at
+			layout_text(show, font, op->args.text, op->args.text_len, &layout, &show->scratch);
+
+			for (j = 0; j < layout.len; j++) {
+
+				if (*bakes_len == *bakes_cap) {
+					*bakes_cap = MAX(*bakes_cap * 2, 256);
+					*bakes = realloc(*bakes, *bakes_cap * sizeof(**bakes));
+					if (!*bakes) {
+						return -1;
+					}
+				}
+
+				bake = *bakes + (*bakes_len)++;
+				bake->fontidx = show->settings.fontidx;
+				bake->fontsize = show->settings.fontsize;
+				bake->codepoint = layout.glyphs[j].codepoint;
+				bake->subx = show->glyphmode == GLYPHMODE_SDF ? 0 : font_subpixel(layout.glyphs[j].x, &x);
+			}
+
+			arena_reset(&show->scratch);
+		}
+
+		if (op->function->state) {
+			op->function->state(show, op);
+		}
+	}
+
+	return 0;
+}
+
+/* prebake_cmp : qsort comparator, orders glyphs by font, then size, then codepoint, then offset */
+int prebake_cmp(const void *a, const void *b)
+{
+	const struct bake_t *x, *y;
+
+	x = a;
+	y = b;
+
+	if (x->fontidx != y->fontidx) {
+		return x->fontidx < y->fontidx ? -1 : 1;
+	}
+
+	if (x->fontsize != y->fontsize) {
+		return x->fontsize < y->fontsize ? -1 : 1;
+	}
+
+	if (x->codepoint != y->codepoint) {
+		return x->codepoint < y->codepoint ? -1 : 1;
+	}
+
+	if (x->subx != y->subx) {
+		return x->subx < y->subx ? -1 : 1;
+	}
+
+	return 0;
+}
+
+/* prebake_worker : rasterizes glyphs off the shared counter until they're gone */
+void *prebake_worker(void *arg)
+{
+	struct bakeworker_t *worker;
+	struct prebake_t *prebake;
+	struct bake_t *bake;
+	size_t idx;
+
+	worker = arg;
+	prebake = worker->prebake;
+
+	for (;;) {
+		idx = __atomic_fetch_add(&prebake->next, 1, __ATOMIC_RELAXED);
+		if (prebake->bakes_len <= idx) {
+			break;
+		}
+
+		bake = prebake->bakes + idx;
+
+		font_getcodepoint(prebake->show->fonts + bake->fontidx, bake->codepoint, bake->fontsize,
+				prebake->show->glyphmode, bake->subx, &worker->scratch);
+
+		arena_reset(&worker->scratch);
+	}
+
+	return NULL;
+}
+
+//
+// Queue Functions
+//
+
+/* queue_init : sets up a bounded queue that holds 'cap' items */
+int queue_init(struct queue_t *queue, size_t cap)
+{
+	assert(queue);
+
+	memset(queue, 0, sizeof(*queue));
+
+	queue->items = calloc(cap, sizeof(*queue->items));
+	if (!queue->items) {
+		return -1;
+	}
+
+	queue->cap = cap;
+
+	pthread_mutex_init(&queue->lock, NULL);
+	pthread_cond_init(&queue->notempty, NULL);
+	pthread_cond_init(&queue->notfull, NULL);
+
+	return 0;
+}
+
+/* queue_push : adds an item to the queue, blocking while it's full */
+int queue_push(struct queue_t *queue, void *item)
+{
+	assert(queue);
+
+	pthread_mutex_lock(&queue->lock);
+
+	while (queue->len == queue->cap) {
+		pthread_cond_wait(&queue->notfull, &queue->lock);
+	}
+
+	queue->items[(queue->head + queue->len) % queue->cap] = item;
+	queue->len++;
+
+	queue->pushes++;
+	queue->occupancy += queue->len;
+	queue->maxlen = MAX(queue->maxlen, queue->len);
+
+	pthread_cond_signal(&queue->notempty);
+	pthread_mutex_unlock(&queue->lock);
+
+	return 0;
+}
+
+/* queue_pop : takes an item off of the queue, blocking while it's empty, NULL once it's closed */
+void *queue_pop(struct queue_t *queue)
+{
+	void *item;
+
+	assert(queue);
+
+	pthread_mutex_lock(&queue->lock);
+
+	while (queue->len == 0 && !queue->closed) {
+		pthread_cond_wait(&queue->notempty, &queue->lock);
+	}
+
+	item = NULL;
+
+	if (queue->len) {
+		item = queue->items[queue->head];
+		queue->head = (queue->head + 1) % queue->cap;
+		queue->len--;
+		pthread_cond_signal(&queue->notfull);
+	}
+
+	pthread_mutex_unlock(&queue->lock);
+
+	return item;
+}
+
+/* queue_close : wakes everyone waiting on the queue, pops return NULL once it's drained */
+int queue_close(struct queue_t *queue)
+{
+	assert(queue);
+
+	pthread_mutex_lock(&queue->lock);
+	queue->closed = 1;
+	pthread_cond_broadcast(&queue->notempty);
+	pthread_mutex_unlock(&queue->lock);
+
+	return 0;
+}
+
+/* queue_free : frees the queue (but not anything still in it) */
+int queue_free(struct queue_t *queue)
+{
+	assert(queue);
+
+	free(queue->items);
+
+	pthread_mutex_destroy(&queue->lock);
+	pthread_cond_destroy(&queue->notempty);
+	pthread_cond_destroy(&queue->notfull);
+
+	return 0;
+}
+
+#if 0
+
+/* show_renderimage : renders the image to the slide */
+int show_renderimage(struct show_t *show, struct image_t *image, s32 x, s32 y)
+{
+	struct pixel_t *iscaled; // image scaled
+	s32 bound_x, bound_y, bound_w, bound_h;
+	s32 img_w, img_h, win_w, win_h;
+	s32 i, j, dst, src;
+	f32 scale;
+	int rc;
+
+	// NOTE (brian)
+	// Before we even attempt to render the image to the window, we have to
+	// determine where in X and Y we can actually fit the image onto the screen.
+	//
+	// We do this by determining the dimensions it has to fit in, then calling
+	// stbir_resize_uint8 on those dimensions, then copying it to the image.
+
+	img_w = image->img_w;
+	img_h = image->img_h;
+	win_w = show->settings.img_w;
+	win_h = show->settings.img_h;
+
+	scale = 1.0f;
+
+	if (win_w < img_w) {
+		scale = (f32)win_w / img_w;
+	}
+
+	if (win_h < img_h) {
+		scale = (f32)win_h / img_h;
+	}
+
+	img_w *= scale;
+	img_h *= scale;
 
 	if (img_w <= win_w && img_h <= win_h) {
 		// copy over parameters if we can fit in the window
@@ -549,624 +2295,2742 @@ int show_renderimage(struct show_t *show, struct image_t *image, s32 x, s32 y)
 		bound_y = (win_w - bound_h) / 2;
 	}
 
-	// before we can put images on the framebuffer, we have to scale them
-	iscaled = calloc(bound_w * bound_h, sizeof(struct pixel_t));
-	rc = stbir_resize_uint8((const u8 *)image->pixels, image->img_w, image->img_h, 0, (u8 *)iscaled, bound_w, bound_h, 0, 4);
-	if (!rc) { // success
-		fprintf(stderr, "Couldn't scale image '%s'\n", image->name);
+	// before we can put images on the framebuffer, we have to scale them
+	iscaled = calloc(bound_w * bound_h, sizeof(struct pixel_t));
+	rc = stbir_resize_uint8((const u8 *)image->pixels, image->img_w, image->img_h, 0, (u8 *)iscaled, bound_w, bound_h, 0, 4);
+	if (!rc) { // success
+		fprintf(stderr, "Couldn't scale image '%s'\n", image->name);
+		return -1;
+	}
+
+	// now we can put the image onto the canvas
+	for (i = 0; i < bound_w; i++) {
+		for (j = 0; j < bound_h; j++) {
+			dst = (i + bound_x) + (j + bound_y) * show->settings.img_w;
+			src = i + j * bound_w;
+			show->fbuffer_fg[dst].r = iscaled[src].r;
+			show->fbuffer_fg[dst].g = iscaled[src].g;
+			show->fbuffer_fg[dst].b = iscaled[src].b;
+			show->fbuffer_fg[dst].a = iscaled[src].a;
+		}
+	}
+
+	free(iscaled);
+
+	return 0;
+}
+
+#endif
+
+/* m_lblend_u8 : linear blend on u8s */
+u8 m_lblend_u8(u8 a, u8 b, f32 t)
+{
+	return (u8)((a + t * (b - a)) + 0.5f);
+}
+
+/* functab_add : adds (or replaces) a callable function in the show */
+int functab_add(struct show_t *show, char *name, s32 run_once, showfunc_t func, parsefunc_t parse, showfunc_t state)
+{
+	struct functab_t *tab;
+	struct function_t **slots;
+	struct function_t *function;
+	size_t i, j, cap;
+
+	assert(show);
+	assert(name);
+
+	tab = &show->functab;
+
+	// NOTE (brian): re-registering a name replaces the function in place, so already compiled ops
+	// pick the new one up
+
+	function = functab_get(show, name, strlen(name));
+	if (function) {
+		function->run_once = run_once;
+		function->func = func;
+		function->parse = parse;
+		function->state = state;
+		return 0;
+	}
+
+	// keep the load factor under 1/2, the capacity is always a power of two
+	if (tab->cap <= (tab->len + 1) * 2) {
+		cap = tab->cap ? tab->cap * 2 : 64;
+		slots = calloc(cap, sizeof(*slots));
+		if (!slots) {
+			return -1;
+		}
+
+		for (i = 0; i < tab->cap; i++) {
+			if (tab->slots[i]) {
+				for (j = c_strhash(tab->slots[i]->name) & (cap - 1); slots[j]; j = (j + 1) & (cap - 1))
+					;
+				slots[j] = tab->slots[i];
+			}
+		}
+
+		free(tab->slots);
+		tab->slots = slots;
+		tab->cap = cap;
+	}
+
+	function = arena_calloc(&show->arena, 1, sizeof(*function));
+	if (!function) {
+		return -1;
+	}
+
+	function->name = arena_strdup(&show->arena, name);
+	function->run_once = run_once;
+	function->func = func;
+	function->parse = parse;
+	function->state = state;
+
+	for (i = c_strhash(name) & (tab->cap - 1); tab->slots[i]; i = (i + 1) & (tab->cap - 1))
+		;
+
+	tab->slots[i] = function;
+	tab->len++;
+
+	return 0;
+}
+
+/* functab_defaults : registers the built in functions */
+int functab_defaults(struct show_t *show)
+{
+	functab_add(show, "blank",        0, func_blank,       NULL,              NULL);
+	functab_add(show, "name",         1, func_name,        NULL,              NULL);
+	functab_add(show, "clear",        0, func_clear,       NULL,              state_clear);
+	functab_add(show, "newslide",     0, func_nop,         NULL,              NULL);
+	functab_add(show, "templateadd",  1, func_templateadd, parse_templateadd, NULL);
+	functab_add(show, "templateset",  0, func_templateset, parse_templateset, state_templateset);
+	functab_add(show, "dimensions",   1, func_dimensions,  parse_dimensions,  NULL);
+	functab_add(show, "printline",    0, func_printline,   parse_printline,   state_printline);
+	functab_add(show, "printdate",    0, func_printdate,   NULL,              NULL);
+	functab_add(show, "fontadd",      1, func_fontadd,     NULL,              NULL);
+	functab_add(show, "fontset",      0, func_fontset,     parse_fontset,     func_fontset);
+	functab_add(show, "fontsizeset",  0, func_fontsizeset, parse_fontsizeset, func_fontsizeset);
+	functab_add(show, "imageadd",     1, func_imageadd,    NULL,              NULL);
+	functab_add(show, "imagedraw",    0, func_imagedraw,   NULL,              NULL);
+
+	return 0;
+}
+
+/* functab_get : returns the function registered under 'name' ('len' bytes), NULL if there isn't one */
+struct function_t *functab_get(struct show_t *show, char *name, size_t len)
+{
+	struct functab_t *tab;
+	size_t i;
+
+	assert(show);
+	assert(name);
+
+	tab = &show->functab;
+
+	if (!tab->cap) {
+		return NULL;
+	}
+
+	for (i = c_hash(name, len, C_HASHSEED) & (tab->cap - 1); tab->slots[i]; i = (i + 1) & (tab->cap - 1)) {
+		if (strlen(tab->slots[i]->name) == len && memcmp(tab->slots[i]->name, name, len) == 0) {
+			return tab->slots[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* functab_free : frees the function registry */
+int functab_free(struct show_t *show)
+{
+	struct functab_t *tab;
+
+	assert(show);
+
+	tab = &show->functab;
+
+	// the functions themselves live in the show's arena
+	free(tab->slots);
+	memset(tab, 0, sizeof(*tab));
+
+	return 0;
+}
+
+//
+// User Callable Functions
+//
+
+/* func_name : user function ; sets the slideshow name, to be run once */
+int func_name(struct show_t *show, struct op_t *op)
+{
+	assert(show);
+
+	if (op->argc < 2) {
+		return -1;
+	}
+
+	show->name = arena_slicedup(&show->arena, op->argv[1]);
+
+	return 0;
+}
+
+/* func_blank : user function ; inserts a blank line at the current cursor position */
+int func_blank(struct show_t *show, struct op_t *op)
+{
+	assert(show);
+
+	return 0;
+}
+
+/* func_clear : user function ; clears framebuffers */
+int func_clear(struct show_t *show, struct op_t *op)
+{
+	s32 bytes;
+	s32 i;
+
+	assert(show);
+
+	bytes = show->settings.img_w * show->settings.img_h;
+
+	for (i = 0; i < ARRSIZE(show->framebuffers); i++) {
+		memset(show->framebuffers[i], 0, bytes);
+	}
+
+	show->settings.pos_x = 60;
+	show->settings.pos_y = 60;
+
+	return 0;
+}
+
+/* func_templateadd : user function ; adds / overwrites a template */
+int func_templateadd(struct show_t *show, struct op_t *op)
+{
+	assert(show);
+
+	C_RESIZE(&show->templates, &show->templates, sizeof(*show->templates));
+
+	show->templates[show->templates_len].name = arena_slicedup(&show->arena, op->argv[1]);
+	show->templates[show->templates_len].bg = op->args.color[0];
+	show->templates[show->templates_len].fg = op->args.color[1];
+	show->templates[show->templates_len].justification = op->args.i[0];
+
+	show->templates_len++;
+
+	return 0;
+}
+
+/* func_templateset : user function ; sets the current template */
+int func_templateset(struct show_t *show, struct op_t *op)
+{
+	assert(show);
+
+	show->settings.template = op->args.i[0];
+
+	return util_fillbg(show);
+}
+
+/* func_printdate : user function ; prints the date at the current line */
+int func_printdate(struct show_t *show, struct op_t *op)
+{
+	return 0;
+}
+
+/* func_printline : user function ; basically, echo */
+int func_printline(struct show_t *show, struct op_t *op)
+{
+	struct font_t *font;
+	struct textrun_t *run;
+	struct strip_t *strip;
+	struct pixel_t fg;
+
+	// NOTE (brian): the line was already joined on spaces, and decoded into codepoints, by
+	// parse_printline. layout_text wraps it to the slide and places every glyph, then the whole
+	// layout gets drawn in one go.
+	//
+	// Layouts are kept as text runs in the font, so a line that shows up on many slides (a
+	// header, a footer, "Agenda") only gets laid out once. Drawing one is a single draw_mask of
+	// its strip, which gets composited in scratch the first time, and kept in the font from the
+	// second time on.
+	//
+	// Every draw of a run has to take the same path, or a slide's pixels would depend on what got
+	// rendered before it, and the render cache counts on one key meaning one image. A strip only
+	// stands in for the glyphs drawn one at a time when the color is opaque, so translucent text
+	// always gets drawn glyph by glyph, as do distance fields, which get sampled right at the pen.
+
+	assert(show);
+
+	// no font to print in (none was added, or it didn't load), so the line gets skipped
+	if (show->settings.fontidx < 0 || show->fonts_len <= show->settings.fontidx || show->settings.fontsize <= 0) {
+		return 0;
+	}
+
+	font = show->fonts + show->settings.fontidx;
+
+	run = layout_run(show, font, op->args.text, op->args.text_len);
+
+	fg = util_fgcolor(show);
+
+	if (show->glyphmode == GLYPHMODE_COVERAGE && fg.a == 0xff) {
+		strip = __atomic_load_n(&run->strip, __ATOMIC_ACQUIRE);
+		if (!strip) {
+			strip = layout_strip(show, font, run, __atomic_add_fetch(&run->uses, 1, __ATOMIC_RELAXED) >= 2);
+		}
+
+		// a run with nothing to draw (all spaces) has no strip
+		if (strip) {
+			draw_mask(show->framebuffers[FRAMEBUFFER_FINAL], strip->coverage,
+					util_rect(0, 0, show->settings.img_w, show->settings.img_h), util_rect(0, 0, strip->w, strip->h),
+					util_rect(strip->x, show->settings.pos_y + strip->y, strip->w, strip->h),
+					util_rect(0, 0, strip->w, strip->h), fg);
+		}
+	} else {
+		layout_draw(show, font, &run->layout);
+	}
+
+	show->settings.pos_x = 0;
+	show->settings.pos_y += run->layout.lines * font_vertadvance(font, show->settings.fontsize);
+
+	return 0;
+}
+
+/* func_dimensions : user function ; sets the output width / height */
+int func_dimensions(struct show_t *show, struct op_t *op)
+{
+	assert(show);
+
+	show->settings.img_w = op->args.i[0];
+	show->settings.img_h = op->args.i[1];
+
+	return 0;
+}
+
+/* func_fontadd : user function ; loads a font, to be run once */
+int func_fontadd(struct show_t *show, struct op_t *op)
+{
+	struct font_t *old;
+	struct slice_t name;
+	struct slice_t path;
+	char buf[BUFLARGE];
+	u64 fileid[2];
+	size_t i;
+	int rc;
+
+	// NOTE (brian): fonts are kept per file, not per name. Adding a file the show already has,
+	// under a new name (or through another path to it), just adds the name, so every alias
+	// shares the one mapping, glyph table and set of atlases.
+
+	assert(show);
+
+	if (op->argc < 2) {
+		return -1;
+	}
+
+	name = op->argv[1];
+	path = *util_assetpath(op);
+
+	snprintf(buf, sizeof buf, "%.*s", SLICE_ARG(path));
+
+	if (sys_fileid(buf, fileid) < 0) {
+		fileid[0] = fileid[1] = 0;
+	}
+
+	for (i = 0; i < show->fonts_len; i++) {
+		if (font_samefile(show->fonts + i, path, fileid)) {
+			return font_nameadd(show, name, i);
+		}
+	}
+
+	C_RESIZE(&show->fonts, &show->fonts, sizeof(*show->fonts));
+
+	// in watch mode, take over the same font from the last load, glyphs and all
+	for (i = 0; i < show->oldfonts_len; i++) {
+		old = show->oldfonts + i;
+		if (old->name && !old->stale && font_samefile(old, path, fileid)) {
+			show->fonts[show->fonts_len++] = *old;
+			memset(old, 0, sizeof(*old));
+			return font_nameadd(show, name, show->fonts_len - 1);
+		}
+	}
+
+	rc = font_load(show->fonts + show->fonts_len, name, path);
+	if (rc < 0) {
+		return -1;
+	}
+
+	memcpy(show->fonts[show->fonts_len].fileid, fileid, sizeof fileid);
+
+	if (show->glyphdir) {
+		font_diskload(show->fonts + show->fonts_len, show->glyphdir);
+	}
+
+	show->fonts_len++;
+
+	return font_nameadd(show, name, show->fonts_len - 1);
+}
+
+/* func_fontset : user function ; sets the font */
+int func_fontset(struct show_t *show, struct op_t *op)
+{
+	assert(show);
+
+	show->settings.fontidx = op->args.i[0];
+
+	return 0;
+}
+
+/* func_fontsizeset : user function ; sets the font size */
+int func_fontsizeset(struct show_t *show, struct op_t *op)
+{
+	assert(show);
+
+	show->settings.fontsize = op->args.i[0];
+
+	return 0;
+}
+
+/* func_imageadd : user function ; loads an image, to be run once */
+int func_imageadd(struct show_t *show, struct op_t *op)
+{
+	return 0;
+}
+
+/* func_imagedraw : user function ; draws the image in an argument dependent way */
+int func_imagedraw(struct show_t *show, struct op_t *op)
+{
+	return 0;
+}
+
+/* func_nop : user(ish) function ; does nothing */
+int func_nop(struct show_t *show, struct op_t *op)
+{
+	return 0;
+}
+
+//
+// Settings Only Functions
+//
+
+/* state_clear : moves the cursor like func_clear, without clearing */
+int state_clear(struct show_t *show, struct op_t *op)
+{
+	assert(show);
+
+	show->settings.pos_x = 60;
+	show->settings.pos_y = 60;
+
+	return 0;
+}
+
+/* state_templateset : sets the current template, without filling the background */
+int state_templateset(struct show_t *show, struct op_t *op)
+{
+	assert(show);
+
+	show->settings.template = op->args.i[0];
+
+	return 0;
+}
+
+/* state_printline : moves the cursor like func_printline, without drawing */
+int state_printline(struct show_t *show, struct op_t *op)
+{
+	struct font_t *font;
+	struct layout_t layout;
+
+	assert(show);
+
+	// no font to print in (none was added, or it didn't load), so the line gets skipped
+	if (show->settings.fontidx < 0 || show->fonts_len <= show->settings.fontidx || show->settings.fontsize <= 0) {
+		return 0;
+	}
+
+	font = show->fonts + show->settings.fontidx;
+
+	// only the number of lines it wraps onto matters here
+	layout_text(show, font, op->args.text, op->args.text_len, &layout, NULL);
+
+	show->settings.pos_x = 0;
+	show->settings.pos_y += layout.lines * font_vertadvance(font, show->settings.fontsize);
+
+	return 0;
+}
+
+//
+// Argument Parsing Functions
+//
+
+/* parse_templateadd : parses the template's colors and justification */
+int parse_templateadd(struct show_t *show, struct op_t *op)
+{
+	struct slice_t justification;
+
+	assert(show);
+
+	if (op->argc < 5) {
+		ERR("[%.*s] : not enough arguments, 5 required, found %d\n", SLICE_ARG(op->argv[0]), op->argc);
+		return -1;
+	}
+
+	op->args.color[0] = util_parsecolor(op->argv[2]);
+	op->args.color[1] = util_parsecolor(op->argv[3]);
+
+	justification = op->argv[4];
+
+	// TODO make nicer
+	if (slice_eq(justification, "left")) {
+		op->args.i[0] = SLIDEJUST_LEFT;
+	} else if (slice_eq(justification, "center")) {
+		op->args.i[0] = SLIDEJUST_CENTER;
+	} else if (slice_eq(justification, "right")) {
+		op->args.i[0] = SLIDEJUST_RIGHT;
+	} else { // default to left
+		op->args.i[0] = SLIDEJUST_LEFT;
+	}
+
+	return 0;
+}
+
+/* parse_templateset : resolves the template name to its index */
+int parse_templateset(struct show_t *show, struct op_t *op)
+{
+	s32 i;
+
+	assert(show);
+
+	if (op->argc < 2) {
+		return -1;
+	}
+
+	for (i = 0; i < show->templates_len; i++) {
+		if (slice_eq(op->argv[1], show->templates[i].name)) {
+			op->args.i[0] = i;
+			return 0;
+		}
+	}
+
+	ERR("Couldn't find template '%.*s'\n", SLICE_ARG(op->argv[1]));
+
+	return -1;
+}
+
+/* parse_dimensions : parses the output width / height */
+int parse_dimensions(struct show_t *show, struct op_t *op)
+{
+	assert(show);
+
+	if (op->argc < 3) {
+		return -1;
+	}
+
+	op->args.i[0] = slice_atoi(op->argv[1]);
+	op->args.i[1] = slice_atoi(op->argv[2]);
+
+	return 0;
+}
+
+/* parse_printline : joins the arguments into the line to print */
+int parse_printline(struct show_t *show, struct op_t *op)
+{
+	size_t len;
+	s32 i;
+
+	assert(show);
+
+	for (i = 1, len = 0; i < op->argc; i++) {
+		len += op->argv[i].len + 1;
+	}
+
+	op->args.str = arena_calloc(&show->arena, len + 1, 1);
+	op->args.str_len = 0;
+
+	for (i = 1; i < op->argc; i++) {
+		memcpy(op->args.str + op->args.str_len, op->argv[i].s, op->argv[i].len);
+		op->args.str_len += op->argv[i].len;
+
+		if (i != op->argc - 1) {
+			op->args.str[op->args.str_len++] = ' ';
+		}
+	}
+
+	// decoded once here, so printing (and prebaking) only ever sees codepoints
+	op->args.text = arena_alloc(&show->arena, (op->args.str_len + 1) * sizeof(*op->args.text));
+	op->args.text_len = util_utf8decode(op->args.text, op->args.str, op->args.str_len);
+
+	return 0;
+}
+
+/* parse_fontset : resolves the font name to its index */
+int parse_fontset(struct show_t *show, struct op_t *op)
+{
+	s32 i;
+
+	assert(show);
+
+	if (op->argc < 2) {
+		return -1;
+	}
+
+	for (i = 0; i < show->fontnames_len; i++) {
+		if (slice_eq(op->argv[1], show->fontnames[i].name)) {
+			op->args.i[0] = show->fontnames[i].fontidx;
+			return 0;
+		}
+	}
+
+	ERR("Couldn't find font '%.*s'\n", SLICE_ARG(op->argv[1]));
+
+	return -1;
+}
+
+/* parse_fontsizeset : parses the font size */
+int parse_fontsizeset(struct show_t *show, struct op_t *op)
+{
+	assert(show);
+
+	if (op->argc < 2) {
+		return -1;
+	}
+
+	op->args.i[0] = slice_atoi(op->argv[1]);
+
+	return 0;
+}
+
+//
+// Text Layout Functions
+//
+
+/* layout_text : wraps and justifies a line of text to the slide, glyphs go in 'scratch' (just measures without it) */
+int layout_text(struct show_t *show, struct font_t *font, u32 *text, size_t len, struct layout_t *layout, struct arena_t *scratch)
+{
+	struct glyphpos_t *glyph;
+	size_t i, first, word, begin, j;
+	s32 pen, end, wordstart, maxw, space;
+	u32 fontsize;
+
+	// NOTE (brian): one pass over the text. Every word gets placed where the pen is, and if that
+	// runs it past the edge of the slide (and it isn't the first word on its line), the line ends
+	// before it, and the word slides back to the start of the next one. Finished lines get justified
+	// right away, so nothing ever gets measured twice.
+	//
+	// Everything is in 26.6 fixed point, from the font's advances and kerning, nothing here needs a
+	// rasterized glyph. Lines are counted rather than positioned, the callers multiply them out by
+	// the line height at the current size (see font_vertadvance).
+
+	assert(show);
+	assert(font);
+	assert(layout);
+
+	fontsize = show->settings.fontsize;
+
+	maxw = (show->settings.img_w - show->settings.pos_x) << 6;
+	space = font_advance(font, ' ', fontsize);
+
+	layout->glyphs = scratch ? arena_alloc(scratch, MAX(len, 1) * sizeof(*layout->glyphs)) : NULL;
+	layout->len = 0;
+	layout->lines = 1;
+
+	pen = end = 0;
+	first = 0;
+
+	for (i = 0; i < len; ) {
+		if (text[i] == ' ') {
+			pen += space;
+			i++;
+			continue;
+		}
+
+		wordstart = pen;
+		word = layout->len;
+
+		for (begin = i; i < len && text[i] != ' '; i++) {
+			if (i != begin) {
+				pen += font_kern(font, text[i - 1], text[i], fontsize);
+			}
+
+			if (layout->glyphs) {
+				glyph = layout->glyphs + layout->len;
+				glyph->codepoint = text[i];
+				glyph->x = pen;
+				glyph->line = layout->lines - 1;
+			}
+
+			layout->len++;
+
+			pen += font_advance(font, text[i], fontsize);
+		}
+
+		// a word that's too long for a line all by itself just runs off the edge
+		if (maxw < pen && first < word) {
+			layout_justify(show, layout, first, word, end, maxw);
+
+			for (j = word; layout->glyphs && j < layout->len; j++) {
+				layout->glyphs[j].x -= wordstart;
+				layout->glyphs[j].line++;
+			}
+
+			pen -= wordstart;
+			first = word;
+			layout->lines++;
+		}
+
+		// trailing spaces don't count towards the width
+		end = pen;
+	}
+
+	layout_justify(show, layout, first, layout->len, end, maxw);
+
+	return 0;
+}
+
+/* layout_justify : moves the glyphs [first, last) of a line 'width' wide, per the current template */
+int layout_justify(struct show_t *show, struct layout_t *layout, size_t first, size_t last, s32 width, s32 maxw)
+{
+	struct template_t *template;
+	size_t i;
+	s32 offset;
+
+	if (!layout->glyphs) {
+		return 0;
+	}
+
+	template = cache_template(show, show->settings.template);
+
+	offset = show->settings.pos_x << 6;
+
+	if (template && template->justification == SLIDEJUST_CENTER) {
+		offset += MAX(maxw - width, 0) / 2;
+	} else if (template && template->justification == SLIDEJUST_RIGHT) {
+		offset += MAX(maxw - width, 0);
+	}
+
+	for (i = first; i < last; i++) {
+		layout->glyphs[i].x += offset;
+	}
+
+	return 0;
+}
+
+/* layout_draw : draws every glyph in the layout, in the current font, size and color */
+int layout_draw(struct show_t *show, struct font_t *font, struct layout_t *layout)
+{
+	struct glyphpos_t *glyph;
+	struct fchar_t *fchar;
+	struct rect_t dstdim, dstrect;
+	struct rect_t srcdim, srcrect;
+	struct pixel_t *dst;
+	struct pixel_t fg;
+	size_t i;
+	s32 x, y, lineh;
+	u32 subx;
+	f32 k;
+
+	// NOTE (brian): the pen positions only get rounded here, to the nearest of SUBPIXEL_STEPS
+	// offsets within a pixel, and the glyph rasterized at that offset gets drawn. Distance fields
+	// get scaled down (or up) from SDF_SIZE, and sampled right where the pen is.
+
+	assert(show);
+
+	dst = show->framebuffers[FRAMEBUFFER_FINAL];
+	dstdim = util_rect(0, 0, show->settings.img_w, show->settings.img_h);
+
+	fg = util_fgcolor(show);
+
+	k = (f32)show->settings.fontsize / SDF_SIZE;
+	lineh = font_vertadvance(font, show->settings.fontsize);
+
+	for (i = 0; i < layout->len; i++) {
+		glyph = layout->glyphs + i;
+
+		y = show->settings.pos_y + glyph->line * lineh;
+
+		if (show->glyphmode == GLYPHMODE_SDF) {
+			fchar = font_glyph(show, font, glyph->codepoint, 0);
+			draw_sdf(dst, dstdim, fchar->coverage, fchar->stride, fchar->f_x, fchar->f_y,
+					glyph->x / 64.0f + fchar->b_x * k, y + fchar->b_y * k, k, fg, &show->scratch);
+			continue;
+		}
+
+		subx = font_subpixel(glyph->x, &x);
+
+		fchar = font_glyph(show, font, glyph->codepoint, subx);
+
+		srcdim  = util_rect(0, 0, fchar->stride, fchar->f_y);
+		srcrect = util_rect(0, 0, fchar->f_x, fchar->f_y);
+
+		dstrect = util_rect(x + fchar->b_x, y + fchar->b_y, fchar->f_x, fchar->f_y);
+
+		draw_mask(dst, fchar->coverage, dstdim, srcdim, dstrect, srcrect, fg);
+	}
+
+	return 0;
+}
+
+/* layout_run : returns the text run for the line with the current settings, laying it out if it's new */
+struct textrun_t *layout_run(struct show_t *show, struct font_t *font, u32 *text, size_t len)
+{
+	struct textrun_t key;
+	struct textrun_t *run;
+	struct template_t *template;
+	struct layout_t layout;
+
+	// NOTE (brian): the same dance as font_getcodepoint, look it up with the read lock, lay it out
+	// with no lock, then put it in with the write lock, unless someone else beat us to it
+
+	template = cache_template(show, show->settings.template);
+
+	memset(&key, 0, sizeof key);
+
+	key.text = text;
+	key.text_len = len;
+	key.fontsize = show->settings.fontsize;
+	key.mode = show->glyphmode;
+	key.justification = template ? template->justification : SLIDEJUST_NONE;
+	key.pos_x = show->settings.pos_x;
+	key.img_w = show->settings.img_w;
+
+	key.key = c_hash(text, len * sizeof(*text), C_HASHSEED);
+	key.key = c_hash(&key.fontsize, sizeof key.fontsize, key.key);
+	key.key = c_hash(&key.mode, sizeof key.mode, key.key);
+	key.key = c_hash(&key.justification, sizeof key.justification, key.key);
+	key.key = c_hash(&key.pos_x, sizeof key.pos_x, key.key);
+	key.key = c_hash(&key.img_w, sizeof key.img_w, key.key);
+
+	pthread_rwlock_rdlock(font->lock);
+	run = layout_findrun(font, &key);
+	pthread_rwlock_unlock(font->lock);
+
+	if (run) {
+		__atomic_add_fetch(&font->run_hits, 1, __ATOMIC_RELAXED);
+		return run;
+	}
+
+	__atomic_add_fetch(&font->run_misses, 1, __ATOMIC_RELAXED);
+
+	layout_text(show, font, text, len, &layout, &show->scratch);
+
+	pthread_rwlock_wrlock(font->lock);
+
+	run = layout_findrun(font, &key);
+	if (run) {
+		pthread_rwlock_unlock(font->lock);
+		return run;
+	}
+
+	// the text came out of the show's arena, and runs outlive the show in watch mode
+	run = arena_alloc(&font->arena, sizeof(*run));
+	assert(run);
+
+	*run = key;
+
+	run->text = arena_alloc(&font->arena, MAX(len, 1) * sizeof(*run->text));
+	run->layout = layout;
+	run->layout.glyphs = arena_alloc(&font->arena, MAX(layout.len, 1) * sizeof(*layout.glyphs));
+
+	assert(run->text && run->layout.glyphs);
+
+	memcpy(run->text, text, len * sizeof(*text));
+	memcpy(run->layout.glyphs, layout.glyphs, layout.len * sizeof(*layout.glyphs));
+
+	layout_insertrun(font, run);
+
+	pthread_rwlock_unlock(font->lock);
+
+	return run;
+}
+
+/* layout_findrun : looks for a text run matching 'key', NULL if there isn't one, with the lock held */
+struct textrun_t *layout_findrun(struct font_t *font, struct textrun_t *key)
+{
+	struct textrun_t *run;
+	size_t i;
+
+	if (!font->runs_cap) {
+		return NULL;
+	}
+
+	for (i = key->key & (font->runs_cap - 1); font->runs[i]; i = (i + 1) & (font->runs_cap - 1)) {
+		run = font->runs[i];
+
+		if (run->key == key->key && run->text_len == key->text_len && run->fontsize == key->fontsize &&
+				run->mode == key->mode && run->justification == key->justification &&
+				run->pos_x == key->pos_x && run->img_w == key->img_w &&
+				memcmp(run->text, key->text, key->text_len * sizeof(*key->text)) == 0) {
+			return run;
+		}
+	}
+
+	return NULL;
+}
+
+/* layout_insertrun : adds a text run to the font's table, with the write lock held */
+int layout_insertrun(struct font_t *font, struct textrun_t *run)
+{
+	struct textrun_t **slots;
+	size_t i, j, cap;
+
+	// NOTE (brian): same scheme as ftab, the key is already a hash
+
+	if (font->runs_cap <= (font->runs_len + 1) * 2) {
+		cap = font->runs_cap ? font->runs_cap * 2 : 64;
+		slots = calloc(cap, sizeof(*slots));
+		if (!slots) {
+			return -1;
+		}
+
+		for (i = 0; i < font->runs_cap; i++) {
+			if (font->runs[i]) {
+				for (j = font->runs[i]->key & (cap - 1); slots[j]; j = (j + 1) & (cap - 1))
+					;
+				slots[j] = font->runs[i];
+			}
+		}
+
+		free(font->runs);
+		font->runs = slots;
+		font->runs_cap = cap;
+	}
+
+	for (i = run->key & (font->runs_cap - 1); font->runs[i]; i = (i + 1) & (font->runs_cap - 1))
+		;
+
+	font->runs[i] = run;
+	font->runs_len++;
+
+	return 0;
+}
+
+/* layout_strip : composites the run's glyphs into one coverage strip, handing it to the run if 'keep' */
+struct strip_t *layout_strip(struct show_t *show, struct font_t *font, struct textrun_t *run, int keep)
+{
+	struct glyphpos_t *glyph;
+	struct fchar_t *fchar;
+	struct strip_t *strip;
+	s32 x0, y0, x1, y1;
+	s32 x, y, gx, gy, i, j, lineh;
+	size_t k, bytes;
+	u8 *dst, *src;
+	u32 subx;
+
+	// NOTE (brian): overlapping coverage combines as a + b - ab. Drawn in an opaque color, that's
+	// what blending the glyphs one after the other works out to, give or take a level of rounding
+	// where they overlap. It isn't for translucent colors, which never get here (see
+	// func_printline). The strip is built in scratch, with no lock, and if it's being kept, copied
+	// into the font's arena with the write lock.
+
+	lineh = font_vertadvance(font, run->fontsize);
+
+	x0 = y0 = INT_MAX;
+	x1 = y1 = INT_MIN;
+
+	for (k = 0; k < run->layout.len; k++) {
+		glyph = run->layout.glyphs + k;
+		subx = font_subpixel(glyph->x, &x);
+		fchar = font_glyph(show, font, glyph->codepoint, subx);
+
+		y = glyph->line * lineh;
+
+		x0 = MIN(x0, x + fchar->b_x);
+		y0 = MIN(y0, y + fchar->b_y);
+		x1 = MAX(x1, x + fchar->b_x + fchar->f_x);
+		y1 = MAX(y1, y + fchar->b_y + fchar->f_y);
+	}
+
+	if (x1 <= x0 || y1 <= y0) {
+		return NULL;
+	}
+
+	bytes = sizeof(*strip) + (size_t)(x1 - x0) * (y1 - y0);
+
+	strip = arena_calloc(&show->scratch, 1, bytes);
+	if (!strip) {
+		return NULL;
+	}
+
+	strip->x = x0;
+	strip->y = y0;
+	strip->w = x1 - x0;
+	strip->h = y1 - y0;
+
+	for (k = 0; k < run->layout.len; k++) {
+		glyph = run->layout.glyphs + k;
+		subx = font_subpixel(glyph->x, &x);
+		fchar = font_glyph(show, font, glyph->codepoint, subx);
+
+		gx = x + fchar->b_x - x0;
+		gy = glyph->line * lineh + fchar->b_y - y0;
+
+		for (j = 0; j < fchar->f_y; j++) {
+			dst = strip->coverage + (gy + j) * strip->w + gx;
+			src = fchar->coverage + j * fchar->stride;
+
+			for (i = 0; i < fchar->f_x; i++) {
+				dst[i] = dst[i] + src[i] - (dst[i] * src[i] + 127) / 255;
+			}
+		}
+	}
+
+	if (!keep) {
+		return strip;
+	}
+
+	pthread_rwlock_wrlock(font->lock);
+
+	// readers don't take the lock, the strip has to be all there before they can see it
+	if (!run->strip) {
+		src = arena_alloc(&font->arena, bytes);
+		if (src) {
+			memcpy(src, strip, bytes);
+			__atomic_store_n(&run->strip, (struct strip_t *)src, __ATOMIC_RELEASE);
+
+			font->strips++;
+			font->strip_bytes += bytes;
+		}
+	}
+
+	pthread_rwlock_unlock(font->lock);
+
+	// whichever strip the run ended up with is the same as ours, byte for byte
+	return strip;
+}
+
+//
+// Utility Functions
+//
+
+/* util_framebuffer : (re)sets the show's internal framebuffer */
+int util_framebuffer(struct show_t *show)
+{
+	s32 i;
+	s32 pixels;
+
+	assert(show);
+
+	pixels = show->settings.img_w * show->settings.img_h;
+
+	for (i = 0; i < ARRSIZE(show->framebuffers); i++) {
+		free(show->framebuffers[i]);
+		show->framebuffers[i] = calloc(pixels, sizeof(struct pixel_t));
+	}
+
+	return 0;
+}
+
+/* util_setdefaults : sets default settings */
+int util_setdefaults(struct show_t *show)
+{
+	assert(show);
+
+	memset(&show->defaults, 0, sizeof show->defaults);
+
+	return 0;
+}
+
+/* util_slidecount : counts the number of slides in the slideshow */
+int util_slidecount(struct show_t *show)
+{
+	assert(show);
+
+	return show->slides_len;
+}
+
+/* util_slideindex : builds the slide table from the show's commands */
+int util_slideindex(struct show_t *show)
+{
+	size_t i;
+
+	assert(show);
+
+	show->slides_len = 0;
+
+	for (i = 0; i < show->commands_len; i++) {
+		if (slice_eq(show->commands[i].argv[0], "newslide")) {
+			if (show->slides_len) {
+				show->slides[show->slides_len - 1].end = i;
+			}
+
+			C_RESIZE(&show->slides, &show->slides, sizeof(*show->slides));
+
+			show->slides[show->slides_len].start = i + 1;
+			show->slides[show->slides_len].end = show->commands_len;
+			show->slides_len++;
+		}
+	}
+
+	return 0;
+}
+
+/* util_fillbg : fills the final framebuffer with the current template's background */
+int util_fillbg(struct show_t *show)
+{
+	struct pixel_t bg;
+	s32 i;
+
+	assert(show);
+
+	if (show->settings.template < 0 || show->templates_len <= show->settings.template) {
+		memset(show->framebuffers[FRAMEBUFFER_FINAL], 0,
+				show->settings.img_w * show->settings.img_h * sizeof(struct pixel_t));
+		return 0;
+	}
+
+	bg = *(struct pixel_t *)&show->templates[show->settings.template].bg;
+
+	for (i = 0; i < show->settings.img_w * show->settings.img_h; i++) {
+		show->framebuffers[FRAMEBUFFER_FINAL][i] = bg;
+	}
+
+	return 0;
+}
+
+/* util_fgcolor : returns the current template's foreground, white without one */
+struct pixel_t util_fgcolor(struct show_t *show)
+{
+	struct pixel_t white = { 0xff, 0xff, 0xff, 0xff };
+
+	assert(show);
+
+	if (show->settings.template < 0 || show->templates_len <= show->settings.template) {
+		return white;
+	}
+
+	return *(struct pixel_t *)&show->templates[show->settings.template].fg;
+}
+
+/* util_parsecolor : parses a color string into a color structure */
+struct color_t util_parsecolor(struct slice_t s)
+{
+	struct color_t color;
+	char buf[BUFSMALL];
+	u32 r, g, b, a;
+	s32 rc;
+
+	memset(&color, 0, sizeof color);
+
+	snprintf(buf, sizeof buf, "%.*s", SLICE_ARG(s));
+
+	rc = sscanf(buf, "0x%2x%2x%2x%2x", &r, &g, &b, &a);
+
+	if (rc != 3 && rc != 4) {
+		ERR("Color Parse Error! '%s'\n", buf);
+		return color;
+	}
+
+	color.r = r;
+	color.g = g;
+	color.b = b;
+	color.a = rc == 4 ? a : 0xff;
+
+	return color;
+}
+
+/* util_assetpath : returns the path a fontadd / imageadd op loads, NULL for other ops */
+struct slice_t *util_assetpath(struct op_t *op)
+{
+	if (!op->function || op->argc < 2) {
+		return NULL;
+	}
+
+	if (op->function->func != func_fontadd && op->function->func != func_imageadd) {
+		return NULL;
+	}
+
+	// NOTE (brian): both are either `name path` or just `path`
+	return op->argc == 2 ? op->argv + 1 : op->argv + 2;
+}
+
+/* util_parsestat : reports how quickly the config file was parsed */
+void util_parsestat(size_t bytes, size_t commands, u64 ns)
+{
+	f64 secs;
+
+	secs = ns / 1e9;
+
+	fprintf(stderr, "parsed %zu bytes (%zu commands) in %.3fms, %.1f MB/s\n", bytes, commands, ns / 1e6,
+			secs > 0 ? bytes / secs / (1 << 20) : 0.0);
+}
+
+/* util_utf8decode : decodes 'len' bytes of utf-8 into dst (room for 'len' codepoints), returns how many it wrote */
+size_t util_utf8decode(u32 *dst, char *src, size_t len)
+{
+	size_t i, j, n;
+	u8 *s;
+
+	// NOTE (brian): most decks are all ascii, so runs of it skip the decoder entirely: the widener
+	// checks a whole vector for high bits at once, and copies out the bytes as codepoints while it's
+	// at it. Only the bytes it stops on go through util_utf8next.
+
+	s = (u8 *)src;
+
+	for (i = 0, j = 0; i < len; ) {
+		n = util_asciiwiden(dst + j, s + i, len - i);
+		i += n;
+		j += n;
+
+		if (i < len) {
+			i += util_utf8next(dst + j++, s + i, len - i);
+		}
+	}
+
+	return j;
+}
+
+/* util_utf8next : decodes one codepoint from the front of src, returns how many bytes it took */
+size_t util_utf8next(u32 *dst, u8 *src, size_t len)
+{
+	size_t need, i;
+	u32 c, min;
+
+	// NOTE (brian): anything malformed (stray continuation bytes, truncated or overlong sequences,
+	// surrogates, past U+10FFFF) costs one byte, and comes out as UTF8_REPLACEMENT
+
+	c = src[0];
+
+	if (c < 0x80) {
+		*dst = c;
+		return 1;
+	} else if ((c & 0xe0) == 0xc0) {
+		need = 1; c &= 0x1f; min = 0x80;
+	} else if ((c & 0xf0) == 0xe0) {
+		need = 2; c &= 0x0f; min = 0x800;
+	} else if ((c & 0xf8) == 0xf0) {
+		need = 3; c &= 0x07; min = 0x10000;
+	} else {
+		*dst = UTF8_REPLACEMENT;
+		return 1;
+	}
+
+	*dst = UTF8_REPLACEMENT;
+
+	if (len <= need) {
+		return 1;
+	}
+
+	for (i = 1; i <= need; i++) {
+		if ((src[i] & 0xc0) != 0x80) {
+			return 1;
+		}
+		c = (c << 6) | (src[i] & 0x3f);
+	}
+
+	if (c < min || 0x10ffff < c || (0xd800 <= c && c <= 0xdfff)) {
+		return 1;
+	}
+
+	*dst = c;
+
+	return need + 1;
+}
+
+/* util_asciiwiden_scalar : widens the ascii prefix of 'n' src bytes into dst, returns its length, eight at a time */
+size_t util_asciiwiden_scalar(u32 *dst, u8 *src, size_t n)
+{
+	size_t i, j;
+	u64 word, high;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		memcpy(&word, src + i, sizeof word);
+
+		// the first byte with its high bit set ends the run
+		high = word & 0x8080808080808080ull;
+		if (high) {
+			n = i + __builtin_ctzll(high) / 8;
+			break;
+		}
+
+		for (j = 0; j < 8; j++) {
+			dst[i + j] = src[i + j];
+		}
+	}
+
+	for (; i < n && src[i] < 0x80; i++) {
+		dst[i] = src[i];
+	}
+
+	return i;
+}
+
+/* util_rect : utility function to fill out a rectangle */
+struct rect_t util_rect(s32 x, s32 y, s32 w, s32 h)
+{
+	struct rect_t r;
+
+	r.x = x;
+	r.y = y;
+	r.w = w;
+	r.h = h;
+
+	return r;
+}
+
+//
+// Framebuffer Functions
+//
+
+// NOTE (brian): row kernels used by draw_rect when blending, and by draw_mask, plus the ascii
+// widener parse_printline decodes with, all chosen by draw_init
+blendfunc_t *draw_blendrow = draw_blendrow_scalar;
+maskfunc_t *draw_maskrow = draw_maskrow_scalar;
+sdffunc_t *draw_sdfrow = draw_sdfrow_scalar;
+asciifunc_t *util_asciiwiden = util_asciiwiden_scalar;
+
+/* draw_init : selects the fastest row kernels the cpu supports, and the ascii widener */
+void draw_init(void)
+{
+	draw_blendrow = draw_blendrow_scalar;
+	draw_maskrow = draw_maskrow_scalar;
+	draw_sdfrow = draw_sdfrow_scalar;
+	util_asciiwiden = util_asciiwiden_scalar;
+
+#if defined(BSLIDES_X86)
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("sse2")) {
+		draw_blendrow = draw_blendrow_sse2;
+		draw_maskrow = draw_maskrow_sse2;
+		draw_sdfrow = draw_sdfrow_sse2;
+		util_asciiwiden = util_asciiwiden_sse2;
+	}
+
+	if (__builtin_cpu_supports("avx2")) {
+		draw_blendrow = draw_blendrow_avx2;
+		draw_maskrow = draw_maskrow_avx2;
+		draw_sdfrow = draw_sdfrow_avx2;
+		util_asciiwiden = util_asciiwiden_avx2;
+	}
+#endif
+}
+
+/* draw_rect : blits a rectangle */
+int draw_rect(struct pixel_t *dst, struct pixel_t *src, struct rect_t dstdim, struct rect_t srcdim, struct rect_t dstrect, struct rect_t srcrect, int blend)
+{
+	s32 y;
+
+	// NOTE (brian): this function assumes that you've already done the work to scale the src to the
+	// destination's dimensions. The source rectangle is copied to (dstrect.x, dstrect.y), and both
+	// rectangles get clipped once up front, so the row loop below never has to check bounds.
+
+	if (!draw_clip(dstdim, srcdim, &dstrect, &srcrect)) {
+		return 0;
+	}
+
+	src += srcrect.x + srcrect.y * srcdim.w;
+	dst += dstrect.x + dstrect.y * dstdim.w;
+
+	for (y = 0; y < srcrect.h; y++, src += srcdim.w, dst += dstdim.w) {
+		if (blend) {
+			draw_blendrow(dst, src, srcrect.w);
+		} else {
+			memcpy(dst, src, srcrect.w * sizeof(*dst));
+		}
+	}
+
+	return 0;
+}
+
+/* draw_mask : blends 'color' onto a rectangle, through an 8 bit coverage mask */
+int draw_mask(struct pixel_t *dst, u8 *src, struct rect_t dstdim, struct rect_t srcdim, struct rect_t dstrect, struct rect_t srcrect, struct pixel_t color)
+{
+	s32 y;
+
+	// NOTE (brian): same as draw_rect, except the source is coverage, and the color comes from the
+	// caller. Glyphs take a quarter of the memory (and bandwidth) this way, and text can be any color.
+
+	if (!draw_clip(dstdim, srcdim, &dstrect, &srcrect)) {
+		return 0;
+	}
+
+	src += srcrect.x + srcrect.y * srcdim.w;
+	dst += dstrect.x + dstrect.y * dstdim.w;
+
+	for (y = 0; y < srcrect.h; y++, src += srcdim.w, dst += dstdim.w) {
+		draw_maskrow(dst, src, color, srcrect.w);
+	}
+
+	return 0;
+}
+
+/* draw_sdf : blends 'color' onto dst through a 'w' x 'h' distance field, scaled by 'k', its corner at (x, y) */
+int draw_sdf(struct pixel_t *dst, struct rect_t dstdim, u8 *sdf, s32 stride, s32 w, s32 h, f32 x, f32 y, f32 k, struct pixel_t color, struct arena_t *scratch)
+{
+	f32 *dist;
+	u8 *cov;
+	u8 *r0, *r1;
+	f32 u, v, fu, fv, band, lo, inv;
+	s32 x0, y0, x1, y1;
+	s32 dx, dy;
+	s32 iu, iv, iu1, iv1;
+
+	// NOTE (brian): every destination pixel inside the (scaled) field samples it bilinearly at its
+	// center, a row at a time, then draw_sdfrow turns the row of distances into coverage, and
+	// draw_maskrow blends it in. Samples past the edge take the edge, which is always outside of
+	// the glyph, thanks to the padding.
+	//
+	// The outline gets a pixel wide smoothstep around it, at the destination's size, which is
+	// SDF_DISTSCALE / k in field units.
+
+	assert(dstdim.x == 0);
+	assert(dstdim.y == 0);
+
+	if (!sdf || w <= 0 || h <= 0 || k <= 0) {
+		return 0;
+	}
+
+	x0 = MAX((s32)floorf(x), 0);
+	y0 = MAX((s32)floorf(y), 0);
+	x1 = MIN((s32)ceilf(x + w * k), dstdim.w);
+	y1 = MIN((s32)ceilf(y + h * k), dstdim.h);
+
+	if (x1 <= x0 || y1 <= y0) {
+		return 0;
+	}
+
+	dist = arena_alloc(scratch, (x1 - x0) * sizeof(*dist));
+	cov = arena_alloc(scratch, x1 - x0);
+
+	if (!dist || !cov) {
 		return -1;
 	}
 
-	// now we can put the image onto the canvas
-	for (i = 0; i < bound_w; i++) {
-		for (j = 0; j < bound_h; j++) {
-			dst = (i + bound_x) + (j + bound_y) * show->settings.img_w;
-			src = i + j * bound_w;
-			show->fbuffer_fg[dst].r = iscaled[src].r;
-			show->fbuffer_fg[dst].g = iscaled[src].g;
-			show->fbuffer_fg[dst].b = iscaled[src].b;
-			show->fbuffer_fg[dst].a = iscaled[src].a;
+	band = 0.5f * SDF_DISTSCALE / k;
+	lo = SDF_ONEDGE - band;
+	inv = 1.0f / (2.0f * band);
+
+	for (dy = y0; dy < y1; dy++) {
+		v = (dy + 0.5f - y) / k - 0.5f;
+		v = MIN(MAX(v, 0.0f), h - 1);
+		iv = (s32)v;
+		iv1 = MIN(iv + 1, h - 1);
+		fv = v - iv;
+
+		r0 = sdf + iv * stride;
+		r1 = sdf + iv1 * stride;
+
+		for (dx = x0; dx < x1; dx++) {
+			u = (dx + 0.5f - x) / k - 0.5f;
+			u = MIN(MAX(u, 0.0f), w - 1);
+			iu = (s32)u;
+			iu1 = MIN(iu + 1, w - 1);
+			fu = u - iu;
+
+			dist[dx - x0] = (r0[iu] + (r0[iu1] - r0[iu]) * fu) * (1.0f - fv) + (r1[iu] + (r1[iu1] - r1[iu]) * fu) * fv;
 		}
-	}
 
-	free(iscaled);
+		draw_sdfrow(cov, dist, lo, inv, x1 - x0);
+		draw_maskrow(dst + x0 + dy * dstdim.w, cov, color, x1 - x0);
+	}
 
 	return 0;
 }
 
-#endif
+/* draw_clip : clips both rectangles against their surfaces, returns 0 if nothing is left */
+int draw_clip(struct rect_t dstdim, struct rect_t srcdim, struct rect_t *dstrect, struct rect_t *srcrect)
+{
+	s32 src_x, src_y;
+	s32 dst_x, dst_y;
+	s32 w, h;
 
-/* m_lblend_u8 : linear blend on u8s */
-u8 m_lblend_u8(u8 a, u8 b, f32 t)
+	assert(dstdim.x == 0);
+	assert(dstdim.y == 0);
+	assert(srcdim.x == 0);
+	assert(srcdim.y == 0);
+
+	src_x = srcrect->x;
+	src_y = srcrect->y;
+	dst_x = dstrect->x;
+	dst_y = dstrect->y;
+	w = srcrect->w;
+	h = srcrect->h;
+
+	// clip the top left corner against both surfaces
+	if (src_x < 0) { dst_x -= src_x; w += src_x; src_x = 0; }
+	if (src_y < 0) { dst_y -= src_y; h += src_y; src_y = 0; }
+	if (dst_x < 0) { src_x -= dst_x; w += dst_x; dst_x = 0; }
+	if (dst_y < 0) { src_y -= dst_y; h += dst_y; dst_y = 0; }
+
+	// then the bottom right corner
+	w = MIN(w, MIN(srcdim.w - src_x, dstdim.w - dst_x));
+	h = MIN(h, MIN(srcdim.h - src_y, dstdim.h - dst_y));
+
+	if (w <= 0 || h <= 0) {
+		return 0;
+	}
+
+	*srcrect = util_rect(src_x, src_y, w, h);
+	*dstrect = util_rect(dst_x, dst_y, w, h);
+
+	return 1;
+}
+
+/* draw_blendrow_scalar : alpha blends 'n' src pixels onto dst, one at a time */
+void draw_blendrow_scalar(struct pixel_t *dst, struct pixel_t *src, s32 n)
 {
-	return (u8)((a + t * (b - a)) + 0.5f);
+	s32 i;
+	u32 a, ia;
+
+	// NOTE (brian): (d * (255 - a) + s * a + 127) / 255 is bit-exact with the old float path,
+	// m_lblend_u8(d, s, a / 255.0f), for every input. The vector kernels compute the same thing.
+
+	for (i = 0; i < n; i++) {
+		a = src[i].a;
+		ia = 255 - a;
+		dst[i].r = (dst[i].r * ia + src[i].r * a + 127) / 255;
+		dst[i].g = (dst[i].g * ia + src[i].g * a + 127) / 255;
+		dst[i].b = (dst[i].b * ia + src[i].b * a + 127) / 255;
+		dst[i].a = 0xff;
+	}
 }
 
-/* functab_add : adds a callable function into the show */
-int functab_add(struct show_t *show, char *name, s32 run_once, showfunc_t func)
+/* draw_maskrow_scalar : blends 'color' onto 'n' dst pixels, by src coverage, one at a time */
+void draw_maskrow_scalar(struct pixel_t *dst, u8 *src, struct pixel_t color, s32 n)
 {
-	assert(show);
-	assert(show->functions_len < MAX_FUNCTIONS);
+	s32 i;
+	u32 a, ia;
+
+	// NOTE (brian): the color's own alpha scales the coverage, an opaque color blends exactly like
+	// draw_blendrow would with a (color, coverage) source pixel. Where that comes out to nothing,
+	// dst is left alone, alpha included, so the empty parts of a glyph (or a strip) don't turn a
+	// cleared, transparent framebuffer black.
+
+	for (i = 0; i < n; i++) {
+		a = (src[i] * color.a + 127) / 255;
+		ia = 255 - a;
+		dst[i].r = (dst[i].r * ia + color.r * a + 127) / 255;
+		dst[i].g = (dst[i].g * ia + color.g * a + 127) / 255;
+		dst[i].b = (dst[i].b * ia + color.b * a + 127) / 255;
+		dst[i].a = a ? 0xff : dst[i].a;
+	}
+}
 
-	show->functions[show->functions_len].name = strdup(name);
-	show->functions[show->functions_len].run_once = run_once;
-	show->functions[show->functions_len].func = func;
+/* draw_sdfrow_scalar : turns 'n' distances into coverage, smoothstep from 'lo' over 1 / 'inv', one at a time */
+void draw_sdfrow_scalar(u8 *dst, f32 *src, f32 lo, f32 inv, s32 n)
+{
+	s32 i;
+	f32 t;
 
-	show->functions_len++;
+	// NOTE (brian): the vector kernels do the same float ops in the same order, so they match this
+	// bit for bit
 
-	return 0;
+	for (i = 0; i < n; i++) {
+		t = (src[i] - lo) * inv;
+		t = MIN(MAX(t, 0.0f), 1.0f);
+		dst[i] = (u8)(t * t * (3.0f - 2.0f * t) * 255.0f + 0.5f);
+	}
 }
 
-//
-// User Callable Functions
-//
+#if defined(BSLIDES_X86)
 
-/* func_name : user function ; sets the slideshow name, to be run once */
-int func_name(struct show_t *show, int argc, char **argv)
+/* draw_blendrow_sse2 : alpha blends 'n' src pixels onto dst, four at a time */
+__attribute__((target("sse2")))
+void draw_blendrow_sse2(struct pixel_t *dst, struct pixel_t *src, s32 n)
 {
-	assert(show);
+	__m128i zero, c127, c255, opaque;
+	__m128i s, d, s_lo, s_hi, d_lo, d_hi, a_lo, a_hi, lo, hi;
+	s32 i;
 
-	if (argc < 2) {
-		return -1;
-	}
+	zero   = _mm_setzero_si128();
+	c127   = _mm_set1_epi16(127);
+	c255   = _mm_set1_epi16(255);
+	opaque = _mm_set1_epi32((s32)0xff000000);
 
-	show->name = strdup(argv[1]);
+	for (i = 0; i + 4 <= n; i += 4) {
+		s = _mm_loadu_si128((__m128i *)(src + i));
+		d = _mm_loadu_si128((__m128i *)(dst + i));
 
-	return 0;
-}
+		s_lo = _mm_unpacklo_epi8(s, zero);
+		s_hi = _mm_unpackhi_epi8(s, zero);
+		d_lo = _mm_unpacklo_epi8(d, zero);
+		d_hi = _mm_unpackhi_epi8(d, zero);
 
-/* func_blank : user function ; inserts a blank line at the current cursor position */
-int func_blank(struct show_t *show, int argc, char **argv)
-{
-	assert(show);
+		// broadcast each pixel's alpha across its four channels
+		a_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_lo, 0xff), 0xff);
+		a_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_hi, 0xff), 0xff);
 
-	return 0;
+		lo = _mm_add_epi16(_mm_mullo_epi16(s_lo, a_lo), _mm_mullo_epi16(d_lo, _mm_sub_epi16(c255, a_lo)));
+		hi = _mm_add_epi16(_mm_mullo_epi16(s_hi, a_hi), _mm_mullo_epi16(d_hi, _mm_sub_epi16(c255, a_hi)));
+		lo = _mm_add_epi16(lo, c127);
+		hi = _mm_add_epi16(hi, c127);
+
+		// DIV255, in 16 bit lanes
+		lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, _mm_set1_epi16(1)), _mm_srli_epi16(lo, 8)), 8);
+		hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, _mm_set1_epi16(1)), _mm_srli_epi16(hi, 8)), 8);
+
+		d = _mm_or_si128(_mm_packus_epi16(lo, hi), opaque);
+
+		_mm_storeu_si128((__m128i *)(dst + i), d);
+	}
+
+	draw_blendrow_scalar(dst + i, src + i, n - i);
 }
 
-/* func_clear : user function ; clears framebuffers */
-int func_clear(struct show_t *show, int argc, char **argv)
+/* draw_blendrow_avx2 : alpha blends 'n' src pixels onto dst, eight at a time */
+__attribute__((target("avx2")))
+void draw_blendrow_avx2(struct pixel_t *dst, struct pixel_t *src, s32 n)
 {
-	s32 bytes;
+	__m256i zero, c127, c255, opaque;
+	__m256i s, d, s_lo, s_hi, d_lo, d_hi, a_lo, a_hi, lo, hi;
 	s32 i;
 
-	assert(show);
+	zero   = _mm256_setzero_si256();
+	c127   = _mm256_set1_epi16(127);
+	c255   = _mm256_set1_epi16(255);
+	opaque = _mm256_set1_epi32((s32)0xff000000);
 
-	bytes = show->settings.img_w * show->settings.img_h;
+	// NOTE (brian): unpack and pack both work within 128 bit lanes, so pixel order is preserved
 
-	for (i = 0; i < ARRSIZE(show->framebuffers); i++) {
-		memset(show->framebuffers[i], 0, bytes);
+	for (i = 0; i + 8 <= n; i += 8) {
+		s = _mm256_loadu_si256((__m256i *)(src + i));
+		d = _mm256_loadu_si256((__m256i *)(dst + i));
+
+		s_lo = _mm256_unpacklo_epi8(s, zero);
+		s_hi = _mm256_unpackhi_epi8(s, zero);
+		d_lo = _mm256_unpacklo_epi8(d, zero);
+		d_hi = _mm256_unpackhi_epi8(d, zero);
+
+		a_lo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s_lo, 0xff), 0xff);
+		a_hi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s_hi, 0xff), 0xff);
+
+		lo = _mm256_add_epi16(_mm256_mullo_epi16(s_lo, a_lo), _mm256_mullo_epi16(d_lo, _mm256_sub_epi16(c255, a_lo)));
+		hi = _mm256_add_epi16(_mm256_mullo_epi16(s_hi, a_hi), _mm256_mullo_epi16(d_hi, _mm256_sub_epi16(c255, a_hi)));
+		lo = _mm256_add_epi16(lo, c127);
+		hi = _mm256_add_epi16(hi, c127);
+
+		lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(lo, _mm256_set1_epi16(1)), _mm256_srli_epi16(lo, 8)), 8);
+		hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(hi, _mm256_set1_epi16(1)), _mm256_srli_epi16(hi, 8)), 8);
+
+		d = _mm256_or_si256(_mm256_packus_epi16(lo, hi), opaque);
+
+		_mm256_storeu_si256((__m256i *)(dst + i), d);
 	}
 
-	show->settings.pos_x = 60;
-	show->settings.pos_y = 60;
+	// leave the upper halves clean, or every legacy SSE instruction after this (libm's, stb's)
+	// pays for the transition
+	_mm256_zeroupper();
 
-	return 0;
+	draw_blendrow_sse2(dst + i, src + i, n - i);
 }
 
-/* func_templateadd : user function ; adds / overwrites a template */
-int func_templateadd(struct show_t *show, int argc, char **argv)
+/* draw_maskrow_sse2 : blends 'color' onto 'n' dst pixels, by src coverage, four at a time */
+__attribute__((target("sse2")))
+void draw_maskrow_sse2(struct pixel_t *dst, u8 *src, struct pixel_t color, s32 n)
 {
-	char *name;
-	char *justification;
-	color_t bg, fg;
+	__m128i zero, c127, c255, opaque, c, ca;
+	__m128i m, d, d_lo, d_hi, a_lo, a_hi, lo, hi;
+	s32 i;
+	u32 cov;
 
-	assert(show);
+	zero   = _mm_setzero_si128();
+	c127   = _mm_set1_epi16(127);
+	c255   = _mm_set1_epi16(255);
+	opaque = _mm_set1_epi32((s32)0xff000000);
+	c      = _mm_setr_epi16(color.r, color.g, color.b, 0, color.r, color.g, color.b, 0);
+	ca     = _mm_set1_epi16(color.a);
 
-	C_RESIZE(&show->templates, &show->templates, sizeof(*show->templates));
+	for (i = 0; i + 4 <= n; i += 4) {
+		memcpy(&cov, src + i, sizeof cov);
 
-	if (argc < 5) {
-		ERR("[%s] : not enough arguments, 5 required, found %d\n", argv[0], argc);
-		return -1;
+		d = _mm_loadu_si128((__m128i *)(dst + i));
+
+		d_lo = _mm_unpacklo_epi8(d, zero);
+		d_hi = _mm_unpackhi_epi8(d, zero);
+
+		// widen each coverage byte to a 32 bit lane, then broadcast it across its pixel's channels
+		m = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((s32)cov), zero), zero);
+		m = _mm_or_si128(m, _mm_slli_epi32(m, 16));
+		a_lo = _mm_unpacklo_epi32(m, m);
+		a_hi = _mm_unpackhi_epi32(m, m);
+
+		// scale by the color's alpha
+		a_lo = _mm_add_epi16(_mm_mullo_epi16(a_lo, ca), c127);
+		a_hi = _mm_add_epi16(_mm_mullo_epi16(a_hi, ca), c127);
+		a_lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(a_lo, _mm_set1_epi16(1)), _mm_srli_epi16(a_lo, 8)), 8);
+		a_hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(a_hi, _mm_set1_epi16(1)), _mm_srli_epi16(a_hi, 8)), 8);
+
+		lo = _mm_add_epi16(_mm_mullo_epi16(c, a_lo), _mm_mullo_epi16(d_lo, _mm_sub_epi16(c255, a_lo)));
+		hi = _mm_add_epi16(_mm_mullo_epi16(c, a_hi), _mm_mullo_epi16(d_hi, _mm_sub_epi16(c255, a_hi)));
+		lo = _mm_add_epi16(lo, c127);
+		hi = _mm_add_epi16(hi, c127);
+
+		lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, _mm_set1_epi16(1)), _mm_srli_epi16(lo, 8)), 8);
+		hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, _mm_set1_epi16(1)), _mm_srli_epi16(hi, 8)), 8);
+
+		// alpha comes out as dst's own where the weight is 0, only make the rest opaque
+		m = _mm_cmpeq_epi32(_mm_packus_epi16(a_lo, a_hi), zero);
+		d = _mm_or_si128(_mm_packus_epi16(lo, hi), _mm_andnot_si128(m, opaque));
+
+		_mm_storeu_si128((__m128i *)(dst + i), d);
 	}
 
-	name = argv[1];
-	bg = util_parsecolor(argv[2]);
-	fg = util_parsecolor(argv[3]);
-	justification = argv[4];
+	draw_maskrow_scalar(dst + i, src + i, color, n - i);
+}
+
+/* draw_maskrow_avx2 : blends 'color' onto 'n' dst pixels, by src coverage, eight at a time */
+__attribute__((target("avx2")))
+void draw_maskrow_avx2(struct pixel_t *dst, u8 *src, struct pixel_t color, s32 n)
+{
+	__m256i zero, c127, c255, opaque, c, ca;
+	__m256i m, d, d_lo, d_hi, a_lo, a_hi, lo, hi;
+	s32 i;
+	u64 cov;
+
+	zero   = _mm256_setzero_si256();
+	c127   = _mm256_set1_epi16(127);
+	c255   = _mm256_set1_epi16(255);
+	opaque = _mm256_set1_epi32((s32)0xff000000);
+	c      = _mm256_setr_epi16(color.r, color.g, color.b, 0, color.r, color.g, color.b, 0,
+			color.r, color.g, color.b, 0, color.r, color.g, color.b, 0);
+	ca     = _mm256_set1_epi16(color.a);
 
-	show->templates[show->templates_len].name = strdup(name);
-	show->templates[show->templates_len].bg = bg;
-	show->templates[show->templates_len].fg = fg;
+	// NOTE (brian): unpacking dst splits each 128 bit lane's pixels in halves, and unpacking the
+	// coverage (one pixel per 32 bit lane) against itself splits it up the same way
 
-	// TODO make nicer
-	if (streq(justification, "left")) {
-		show->templates[show->templates_len].justification = SLIDEJUST_LEFT;
-	} else if (streq(justification, "center")) {
-		show->templates[show->templates_len].justification = SLIDEJUST_CENTER;
-	} else if (streq(justification, "right")) {
-		show->templates[show->templates_len].justification = SLIDEJUST_RIGHT;
-	} else { // default to left
-		show->templates[show->templates_len].justification = SLIDEJUST_LEFT;
+	for (i = 0; i + 8 <= n; i += 8) {
+		memcpy(&cov, src + i, sizeof cov);
+
+		d = _mm256_loadu_si256((__m256i *)(dst + i));
+
+		d_lo = _mm256_unpacklo_epi8(d, zero);
+		d_hi = _mm256_unpackhi_epi8(d, zero);
+
+		m = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128((s64)cov));
+		m = _mm256_or_si256(m, _mm256_slli_epi32(m, 16));
+		a_lo = _mm256_unpacklo_epi32(m, m);
+		a_hi = _mm256_unpackhi_epi32(m, m);
+
+		a_lo = _mm256_add_epi16(_mm256_mullo_epi16(a_lo, ca), c127);
+		a_hi = _mm256_add_epi16(_mm256_mullo_epi16(a_hi, ca), c127);
+		a_lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(a_lo, _mm256_set1_epi16(1)), _mm256_srli_epi16(a_lo, 8)), 8);
+		a_hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(a_hi, _mm256_set1_epi16(1)), _mm256_srli_epi16(a_hi, 8)), 8);
+
+		lo = _mm256_add_epi16(_mm256_mullo_epi16(c, a_lo), _mm256_mullo_epi16(d_lo, _mm256_sub_epi16(c255, a_lo)));
+		hi = _mm256_add_epi16(_mm256_mullo_epi16(c, a_hi), _mm256_mullo_epi16(d_hi, _mm256_sub_epi16(c255, a_hi)));
+		lo = _mm256_add_epi16(lo, c127);
+		hi = _mm256_add_epi16(hi, c127);
+
+		lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(lo, _mm256_set1_epi16(1)), _mm256_srli_epi16(lo, 8)), 8);
+		hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(hi, _mm256_set1_epi16(1)), _mm256_srli_epi16(hi, 8)), 8);
+
+		m = _mm256_cmpeq_epi32(_mm256_packus_epi16(a_lo, a_hi), zero);
+		d = _mm256_or_si256(_mm256_packus_epi16(lo, hi), _mm256_andnot_si256(m, opaque));
+
+		_mm256_storeu_si256((__m256i *)(dst + i), d);
 	}
 
-	show->templates_len++;
+	// leave the upper halves clean, or every legacy SSE instruction after this (libm's, stb's)
+	// pays for the transition
+	_mm256_zeroupper();
 
-	return 0;
+	draw_maskrow_sse2(dst + i, src + i, color, n - i);
 }
 
-/* func_templateset : user function ; sets the current template */
-int func_templateset(struct show_t *show, int argc, char **argv)
+/* draw_sdfrow_sse2 : turns 'n' distances into coverage, smoothstep from 'lo' over 1 / 'inv', four at a time */
+__attribute__((target("sse2")))
+void draw_sdfrow_sse2(u8 *dst, f32 *src, f32 lo, f32 inv, s32 n)
+{
+	__m128 vlo, vinv, zero, one, two, three, c255, half, t;
+	__m128i c;
+	s32 i;
+	u32 out;
+
+	vlo   = _mm_set1_ps(lo);
+	vinv  = _mm_set1_ps(inv);
+	zero  = _mm_setzero_ps();
+	one   = _mm_set1_ps(1.0f);
+	two   = _mm_set1_ps(2.0f);
+	three = _mm_set1_ps(3.0f);
+	c255  = _mm_set1_ps(255.0f);
+	half  = _mm_set1_ps(0.5f);
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		t = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(src + i), vlo), vinv);
+		t = _mm_min_ps(_mm_max_ps(t, zero), one);
+		t = _mm_mul_ps(_mm_mul_ps(t, t), _mm_sub_ps(three, _mm_mul_ps(two, t)));
+		t = _mm_add_ps(_mm_mul_ps(t, c255), half);
+
+		// truncate, like the cast in the scalar kernel, then narrow 32 -> 16 -> 8 bits
+		c = _mm_cvttps_epi32(t);
+		c = _mm_packs_epi32(c, c);
+		c = _mm_packus_epi16(c, c);
+
+		out = (u32)_mm_cvtsi128_si32(c);
+		memcpy(dst + i, &out, sizeof out);
+	}
+
+	draw_sdfrow_scalar(dst + i, src + i, lo, inv, n - i);
+}
+
+/* draw_sdfrow_avx2 : turns 'n' distances into coverage, smoothstep from 'lo' over 1 / 'inv', eight at a time */
+__attribute__((target("avx2")))
+void draw_sdfrow_avx2(u8 *dst, f32 *src, f32 lo, f32 inv, s32 n)
 {
-	struct color_t bg;
+	__m256 vlo, vinv, zero, one, two, three, c255, half, t;
+	__m256i c;
+	__m128i p;
 	s32 i;
+	u64 out;
+
+	vlo   = _mm256_set1_ps(lo);
+	vinv  = _mm256_set1_ps(inv);
+	zero  = _mm256_setzero_ps();
+	one   = _mm256_set1_ps(1.0f);
+	two   = _mm256_set1_ps(2.0f);
+	three = _mm256_set1_ps(3.0f);
+	c255  = _mm256_set1_ps(255.0f);
+	half  = _mm256_set1_ps(0.5f);
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		t = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(src + i), vlo), vinv);
+		t = _mm256_min_ps(_mm256_max_ps(t, zero), one);
+		t = _mm256_mul_ps(_mm256_mul_ps(t, t), _mm256_sub_ps(three, _mm256_mul_ps(two, t)));
+		t = _mm256_add_ps(_mm256_mul_ps(t, c255), half);
+
+		c = _mm256_cvttps_epi32(t);
+
+		// the packs work within 128 bit lanes, so narrow the two halves together instead
+		p = _mm_packs_epi32(_mm256_castsi256_si128(c), _mm256_extracti128_si256(c, 1));
+		p = _mm_packus_epi16(p, p);
+
+		out = (u64)_mm_cvtsi128_si64(p);
+		memcpy(dst + i, &out, sizeof out);
+	}
 
-	assert(show);
+	// leave the upper halves clean, or every legacy SSE instruction after this (libm's, stb's)
+	// pays for the transition
+	_mm256_zeroupper();
 
-	for (i = 0; i < show->templates_len; i++) {
-		if (streq(show->templates[i].name, argv[1])) {
-			show->settings.template = i;
-			bg = show->templates[show->settings.template].bg;
+	draw_sdfrow_sse2(dst + i, src + i, lo, inv, n - i);
+}
+
+/* util_asciiwiden_sse2 : widens the ascii prefix of 'n' src bytes into dst, returns its length, sixteen at a time */
+__attribute__((target("sse2")))
+size_t util_asciiwiden_sse2(u32 *dst, u8 *src, size_t n)
+{
+	__m128i zero, v, lo, hi;
+	size_t i;
+
+	zero = _mm_setzero_si128();
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		v = _mm_loadu_si128((__m128i *)(src + i));
+
+		// the movemask picks up every byte's high bit, the scalar widener finds which one
+		if (_mm_movemask_epi8(v)) {
+			break;
+		}
+
+		lo = _mm_unpacklo_epi8(v, zero);
+		hi = _mm_unpackhi_epi8(v, zero);
+
+		_mm_storeu_si128((__m128i *)(dst + i +  0), _mm_unpacklo_epi16(lo, zero));
+		_mm_storeu_si128((__m128i *)(dst + i +  4), _mm_unpackhi_epi16(lo, zero));
+		_mm_storeu_si128((__m128i *)(dst + i +  8), _mm_unpacklo_epi16(hi, zero));
+		_mm_storeu_si128((__m128i *)(dst + i + 12), _mm_unpackhi_epi16(hi, zero));
+	}
+
+	return i + util_asciiwiden_scalar(dst + i, src + i, n - i);
+}
+
+/* util_asciiwiden_avx2 : widens the ascii prefix of 'n' src bytes into dst, returns its length, thirty two at a time */
+__attribute__((target("avx2")))
+size_t util_asciiwiden_avx2(u32 *dst, u8 *src, size_t n)
+{
+	__m256i v;
+	size_t i, j;
+
+	for (i = 0; i + 32 <= n; i += 32) {
+		v = _mm256_loadu_si256((__m256i *)(src + i));
+
+		if (_mm256_movemask_epi8(v)) {
 			break;
 		}
+
+		for (j = 0; j < 32; j += 8) {
+			_mm256_storeu_si256((__m256i *)(dst + i + j), _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i *)(src + i + j))));
+		}
 	}
 
-	if (i == show->templates_len) {
+	_mm256_zeroupper();
+
+	return i + util_asciiwiden_sse2(dst + i, src + i, n - i);
+}
+
+#endif
+
+//
+// Font Functions
+//
+
+/* font_load : sets up an entry in the font table with these params */
+s32 font_load(struct font_t *font, struct slice_t name, struct slice_t path)
+{
+	size_t i;
+	s32 lsb;
+
+	assert(font);
+
+	memset(font, 0, sizeof(*font));
+
+	font->name = arena_slicedup(&font->arena, name);
+	font->path = arena_slicedup(&font->arena, path);
+	font->ttfbuffer = sys_mapfile(font->path, &font->ttfsize);
+
+	// NOTE (brian): the font's tables only ever get parsed here, glyph misses just rasterize
+	if (!font->ttfbuffer || !stbtt_InitFont(&font->info, (unsigned char *)font->ttfbuffer,
+				stbtt_GetFontOffsetForIndex((unsigned char *)font->ttfbuffer, 0))) {
+		ERR("Couldn't load font '%s'\n", font->path);
+		if (font->ttfbuffer) {
+			sys_unmapfile(font->ttfbuffer, font->ttfsize);
+		}
+		arena_free(&font->arena);
+		memset(font, 0, sizeof(*font));
 		return -1;
 	}
 
-	for (i = 0; i < show->settings.img_w * show->settings.img_h; i++) {
-		show->framebuffers[FRAMEBUFFER_FINAL][i] = *(struct pixel_t *)&bg;
+	font->info.userdata = NULL;
+
+	stbtt_GetFontVMetrics(&font->info, &font->v_ascent, &font->v_descent, &font->v_linegap);
+
+	// layout measures every character, and the cmap lookup behind each of these isn't free
+	for (i = 0; i < ARRSIZE(font->advances); i++) {
+		stbtt_GetCodepointHMetrics(&font->info, (int)i, font->advances + i, &lsb);
 	}
 
+	// NOTE (brian): the hash names the on disk glyph cache and goes into every slide key, so it has
+	// to change whenever any byte of the file does. The table checksums aren't enough for that
+	// (tools don't always keep them up to date), so this reads the whole file, once, at load.
+	font->hash = c_hash(font->ttfbuffer, font->ttfsize, C_HASHSEED);
+
+	// NOTE (brian): fonts get moved around by value (the font table grows, watch mode hands them
+	// to the next show), and a rwlock can't be, so it lives in the arena, which never moves
+	font->lock = arena_alloc(&font->arena, sizeof(*font->lock));
+
+	assert(font->lock);
+
+	pthread_rwlock_init(font->lock, NULL);
+
 	return 0;
 }
 
-/* func_printdate : user function ; prints the date at the current line */
-int func_printdate(struct show_t *show, int argc, char **argv)
+/* font_samefile : returns true if the font was loaded from the file 'path' / 'fileid' */
+int font_samefile(struct font_t *font, struct slice_t path, u64 *fileid)
+{
+	// without a device and inode to go by, the path has to match exactly
+	if (!fileid[0] && !fileid[1]) {
+		return slice_eq(path, font->path);
+	}
+
+	return font->fileid[0] == fileid[0] && font->fileid[1] == fileid[1];
+}
+
+/* font_nameadd : gives the font at 'fontidx' the name 'name' */
+int font_nameadd(struct show_t *show, struct slice_t name, s32 fontidx)
 {
+	struct fontname_t *fontname;
+
+	assert(show);
+
+	C_RESIZE(&show->fontnames, &show->fontnames, sizeof(*show->fontnames));
+
+	fontname = show->fontnames + show->fontnames_len++;
+
+	fontname->name = arena_slicedup(&show->arena, name);
+	fontname->fontidx = fontidx;
+
 	return 0;
 }
 
-/* func_printline : user function ; basically, echo */
-int func_printline(struct show_t *show, int argc, char **argv)
+/* font_getcodepoint : retrieves the fchar_t from input font and codepoint, rasterizing in 'scratch' */
+struct fchar_t *font_getcodepoint(struct font_t *font, u32 codepoint, u32 fontsize, u32 mode, u32 subx, struct arena_t *scratch)
 {
-	s32 i, j;
-	struct font_t *font;
+	stbtt_fontinfo fontinfo;
+	stbrp_rect rect;
+	struct atlaspage_t *page;
 	struct fchar_t *fchar;
-	char buf[BUFLARGE];
-	struct rect_t dstdim, dstrect;
-	struct rect_t srcdim, srcrect;
+	f32 scale, shift;
+	s32 x0, y0, x1, y1;
+
+	// NOTE (brian): search for the codepoint in the fonttable. if it's there and rendered for the
+	// given size, return it. Otherwise, render the character for the required fontsize, insert it
+	// into the table, then return it.
+	//
+	// The table is shared between the render threads, lookups only take the read lock. A miss
+	// happens in three steps:
+	//
+	//   1. with the write lock, the glyph gets a spot in the atlas for its size
+	//   2. with no lock, it gets rasterized into that spot, nobody else can see it yet
+	//   3. with the write lock again, it goes in the table
+	//
+	// If another thread put the same glyph in the table in the meantime, we use theirs, and our
+	// spot in the atlas goes to waste.
+	//
+	// Distance fields are the same for every size, they're all kept as SDF_SIZE. Coverage glyphs
+	// are kept once per subpixel offset ('subx'), each one is its own entry in the table.
+
+	pthread_rwlock_rdlock(font->lock);
+	fchar = font_findcodepoint(font, codepoint, mode == GLYPHMODE_SDF ? SDF_SIZE : fontsize, mode, subx);
+	pthread_rwlock_unlock(font->lock);
+
+	if (fchar) {
+		__atomic_add_fetch(&font->hits, 1, __ATOMIC_RELAXED);
+		return fchar;
+	}
+
+	__atomic_add_fetch(&font->misses, 1, __ATOMIC_RELAXED);
+
+	if (mode == GLYPHMODE_SDF) {
+		return font_getsdf(font, codepoint, fontsize, scratch);
+	}
+
+	scale = font_scale(font, fontsize);
+	shift = (f32)subx / SUBPIXEL_STEPS;
+
+	stbtt_GetCodepointBitmapBoxSubpixel(&font->info, (int)codepoint, scale, scale, shift, 0, &x0, &y0, &x1, &y1);
+
+	memset(&rect, 0, sizeof rect);
+
+	rect.w = x1 - x0 + ATLAS_PADDING;
+	rect.h = y1 - y0 + ATLAS_PADDING;
+
+	pthread_rwlock_wrlock(font->lock);
+
+	fchar = font_findcodepoint(font, codepoint, fontsize, GLYPHMODE_COVERAGE, subx);
+	if (fchar) {
+		pthread_rwlock_unlock(font->lock);
+		return fchar;
+	}
+
+	page = font_atlasreserve(font, fontsize, &rect);
+
+	pthread_rwlock_unlock(font->lock);
+
+	assert(page);
+
+	// a copy of the parsed font, so stb_truetype allocates out of our scratch arena
+	fontinfo = font->info;
+	fontinfo.userdata = scratch;
+
+	stbtt_MakeCodepointBitmapSubpixel(&fontinfo, page->coverage + rect.y * page->w + rect.x, x1 - x0, y1 - y0, page->w,
+			scale, scale, shift, 0, (int)codepoint);
+
+	pthread_rwlock_wrlock(font->lock);
+
+	fchar = font_findcodepoint(font, codepoint, fontsize, GLYPHMODE_COVERAGE, subx);
+	if (fchar) {
+		pthread_rwlock_unlock(font->lock);
+		return fchar;
+	}
+
+	fchar = arena_calloc(&font->arena, 1, sizeof(*fchar));
+
+	assert(fchar);
+
+	fchar->coverage  = page->coverage + rect.y * page->w + rect.x;
+	fchar->stride    = page->w;
+	fchar->codepoint = codepoint;
+	fchar->fontsize  = fontsize;
+	fchar->mode      = GLYPHMODE_COVERAGE;
+	fchar->subx      = subx;
+	fchar->f_x       = x1 - x0;
+	fchar->f_y       = y1 - y0;
+	fchar->b_x       = x0;
+	fchar->b_y       = y0;
+	fchar->advance   = font_advance(font, codepoint, fontsize);
+
+	font_insertcodepoint(font, fchar);
+
+	pthread_rwlock_unlock(font->lock);
+
+	return fchar;
+}
+
+/* font_getsdf : the miss path of font_getcodepoint, for GLYPHMODE_SDF */
+struct fchar_t *font_getsdf(struct font_t *font, u32 codepoint, u32 fontsize, struct arena_t *scratch)
+{
+	stbtt_fontinfo fontinfo;
+	struct fchar_t *fchar;
+	u8 *sdf;
+	s32 w, h, xoff, yoff, advance, lsb;
+
+	// NOTE (brian): rasterized with no lock held, like the atlas path, then copied into the font's
+	// arena with the write lock. The field is small enough, and there's few enough of them (one per
+	// codepoint), that they don't get an atlas.
+
+	fontinfo = font->info;
+	fontinfo.userdata = scratch;
+
+	sdf = stbtt_GetCodepointSDF(&fontinfo, font_scale(font, SDF_SIZE), (int)codepoint, SDF_PADDING, SDF_ONEDGE,
+			SDF_DISTSCALE, &w, &h, &xoff, &yoff);
+	if (!sdf) {
+		w = h = xoff = yoff = 0;
+	}
+
+	stbtt_GetCodepointHMetrics(&fontinfo, (int)codepoint, &advance, &lsb);
+
+	pthread_rwlock_wrlock(font->lock);
+
+	fchar = font_findcodepoint(font, codepoint, SDF_SIZE, GLYPHMODE_SDF, 0);
+	if (fchar) {
+		pthread_rwlock_unlock(font->lock);
+		return fchar;
+	}
+
+	fchar = arena_calloc(&font->arena, 1, sizeof(*fchar));
+
+	assert(fchar);
+
+	if (sdf) {
+		fchar->coverage = arena_alloc(&font->arena, (size_t)w * h);
+		assert(fchar->coverage);
+		memcpy(fchar->coverage, sdf, (size_t)w * h);
+		font->sdf_bytes += (size_t)w * h;
+	}
+
+	fchar->stride    = w;
+	fchar->codepoint = codepoint;
+	fchar->fontsize  = SDF_SIZE;
+	fchar->mode      = GLYPHMODE_SDF;
+	fchar->f_x       = w;
+	fchar->f_y       = h;
+	fchar->b_x       = xoff;
+	fchar->b_y       = yoff;
+	fchar->advance   = advance;
+
+	font_insertcodepoint(font, fchar);
+
+	pthread_rwlock_unlock(font->lock);
+
+	return fchar;
+}
+
+/* font_atlasreserve : finds room for 'rect' in the atlas for 'fontsize', with the write lock held */
+struct atlaspage_t *font_atlasreserve(struct font_t *font, u32 fontsize, stbrp_rect *rect)
+{
+	struct atlas_t *atlas;
+	struct atlaspage_t *page;
+
+	for (atlas = font->atlases; atlas && atlas->fontsize != fontsize; atlas = atlas->next)
+		;
+
+	if (!atlas) {
+		atlas = arena_calloc(&font->arena, 1, sizeof(*atlas));
+		if (!atlas) {
+			return NULL;
+		}
 
-	// NOTE (brian): string join on spaces, then print from 0 to len
+		// NOTE (brian): a page fits the printable ascii glyphs of its size, give or take
+		atlas->fontsize = fontsize;
+		atlas->side = MIN(MAX((atlas->fontsize * 6 + 63) & ~63, 64), 2048);
 
-	assert(show);
-	assert(show->settings.fontidx >= 0);
+		atlas->next = font->atlases;
+		font->atlases = atlas;
+	}
+
+	page = atlas->pages;
+	if (!page) {
+		page = font_atlaspage(font, atlas, atlas->side, atlas->side);
+		if (!page) {
+			return NULL;
+		}
+	}
 
-	memset(buf, 0, sizeof buf);
+	stbtt_PackFontRangesPackRects(&page->pack, rect, 1);
 
-	font = show->fonts + show->settings.fontidx;
+	// the page is full, the glyph goes on a new one, that's at least big enough for it
+	if (!rect->was_packed) {
+		page = font_atlaspage(font, atlas, MAX(atlas->side, rect->w + ATLAS_PADDING), MAX(atlas->side, rect->h + ATLAS_PADDING));
+		if (!page) {
+			return NULL;
+		}
 
-	for (i = 1; i < argc; i++) {
-		snprintf(buf + strlen(buf), sizeof buf - strlen(buf), "%s", argv[i]);
-		if (i != argc - 1)
-			snprintf(buf + strlen(buf), sizeof buf - strlen(buf), "%s", " ");
+		stbtt_PackFontRangesPackRects(&page->pack, rect, 1);
 	}
 
-	dstdim = util_rect(0, 0, show->settings.img_w, show->settings.img_h);
+	return rect->was_packed ? page : NULL;
+}
 
-	for (i = 0; i < strlen(buf); i++) {
+/* font_atlaspage : adds a 'w' x 'h' page to the atlas, with the write lock held */
+struct atlaspage_t *font_atlaspage(struct font_t *font, struct atlas_t *atlas, s32 w, s32 h)
+{
+	struct atlaspage_t *page;
 
-		if (buf[i] != ' ') {
-			fchar = font_getcodepoint(font, buf[i], show->settings.fontsize);
+	page = arena_calloc(&font->arena, 1, sizeof(*page));
+	if (!page) {
+		return NULL;
+	}
 
-			srcdim  = util_rect(0, 0, fchar->f_x, fchar->f_y);
-			srcrect = srcdim;
+	page->w = w;
+	page->h = h;
+	page->coverage = arena_alloc(&font->arena, (size_t)w * h);
+	if (!page->coverage) {
+		return NULL;
+	}
 
-			dstrect = util_rect(show->settings.pos_x + fchar->b_x, show->settings.pos_y + fchar->b_y,
-					fchar->f_x, fchar->f_y);
+	// NOTE (brian): the pack context lives in the font's arena too, so stbtt_PackEnd never gets
+	// called, and the allocator context can't go stale when the font moves
+	if (!stbtt_PackBegin(&page->pack, page->coverage, w, h, 0, ATLAS_PADDING, &font->arena)) {
+		return NULL;
+	}
 
-			draw_rect(show->framebuffers[FRAMEBUFFER_FINAL], fchar->bitmap, dstdim, srcdim, dstrect, srcrect, 1);
+	page->pack.user_allocator_context = NULL;
 
-			show->settings.pos_x += fchar->advance;
-		} else {
-			show->settings.pos_x += 18; // TODO determine how far we should move on space!!
-		}
-	}
+	page->next = atlas->pages;
+	atlas->pages = page;
 
-	show->settings.pos_x = 0;
-	show->settings.pos_y += font_vertadvance(font);
+	font->atlas_pages++;
+	font->atlas_bytes += (size_t)w * h;
 
-	return 0;
+	return page;
 }
 
-/* func_dimensions : user function ; sets the output width / height */
-int func_dimensions(struct show_t *show, int argc, char **argv)
+/* font_findcodepoint : looks for an already rendered codepoint, NULL if there isn't one */
+struct fchar_t *font_findcodepoint(struct font_t *font, u32 codepoint, u32 fontsize, u32 mode, u32 subx)
 {
-	assert(show);
+	struct fchar_t *fchar;
+	size_t i;
 
-	if (argc < 2) {
-		return -1;
+	if (!font->ftab_cap) {
+		return NULL;
 	}
 
-	show->settings.img_w = atoi(argv[1]);
-	show->settings.img_h = atoi(argv[2]);
+	for (i = font_glyphhash(codepoint, fontsize, subx) & (font->ftab_cap - 1); font->ftab[i]; i = (i + 1) & (font->ftab_cap - 1)) {
+		fchar = font->ftab[i];
+		if (fchar->codepoint == codepoint && fchar->fontsize == fontsize && fchar->mode == mode && fchar->subx == subx) {
+			return fchar;
+		}
+	}
 
-	return 0;
+	return NULL;
 }
 
-/* func_fontadd : user function ; loads a font, to be run once */
-int func_fontadd(struct show_t *show, int argc, char **argv)
+/* font_insertcodepoint : adds a rendered codepoint to the font's table, with the write lock held */
+int font_insertcodepoint(struct font_t *font, struct fchar_t *fchar)
 {
-	char *name;
-	char *path;
-	int rc;
+	struct fchar_t **slots;
+	size_t i, j, cap;
 
-	assert(show);
+	// NOTE (brian): same scheme as the function table, linear probing, a power of two slots, and
+	// never more than half of them full
 
-	switch (argc) {
-		case 0:
-		case 1:
-		{
+	if (font->ftab_cap <= (font->ftab_len + 1) * 2) {
+		cap = font->ftab_cap ? font->ftab_cap * 2 : 256;
+		slots = calloc(cap, sizeof(*slots));
+		if (!slots) {
 			return -1;
 		}
 
-		case 3:
-		{
-			name = argv[1];
-			path = argv[2];
-			break;
+		for (i = 0; i < font->ftab_cap; i++) {
+			if (font->ftab[i]) {
+				for (j = font_glyphhash(font->ftab[i]->codepoint, font->ftab[i]->fontsize, font->ftab[i]->subx) & (cap - 1); slots[j]; j = (j + 1) & (cap - 1))
+					;
+				slots[j] = font->ftab[i];
+			}
 		}
 
-		case 2:
-		{
-			name = argv[1];
-			path = argv[1];
-			break;
-		}
+		free(font->ftab);
+		font->ftab = slots;
+		font->ftab_cap = cap;
 	}
 
-	C_RESIZE(&show->fonts, &show->fonts, sizeof(*show->fonts));
-
-	rc = font_load(show->fonts + show->fonts_len, name, path);
-	if (rc < 0) {
-		return -1;
-	}
+	for (i = font_glyphhash(fchar->codepoint, fchar->fontsize, fchar->subx) & (font->ftab_cap - 1); font->ftab[i]; i = (i + 1) & (font->ftab_cap - 1))
+		;
 
-	show->fonts_len++;
+	font->ftab[i] = fchar;
+	font->ftab_len++;
 
 	return 0;
 }
 
-/* func_fontset : user function ; sets the font */
-int func_fontset(struct show_t *show, int argc, char **argv)
+/* font_glyphhash : hashes a (codepoint, fontsize, subx) triple */
+u64 font_glyphhash(u32 codepoint, u32 fontsize, u32 subx)
 {
-	s32 i;
+	u64 key;
 
-	assert(show);
+	// fibonacci hashing, the high bits are the good ones, so fold them down
+	key = ((u64)(fontsize * SUBPIXEL_STEPS + subx) << 32 | codepoint) * 0x9e3779b97f4a7c15ULL;
 
-	if (argc < 2) {
-		return -1;
+	return key ^ (key >> 32);
+}
+
+/* font_kernadd : adds the pair (a, b) to the font's kerning table, if it isn't already there */
+int font_kernadd(struct font_t *font, u32 a, u32 b)
+{
+	struct kernpair_t *slots;
+	size_t i, j, cap;
+
+	// NOTE (brian): same scheme as ftab, keyed with font_glyphhash, which works just as well on a
+	// pair of codepoints as on a (codepoint, fontsize) pair (subx is always 0 here)
+
+	if (font->kerns_cap <= (font->kerns_len + 1) * 2) {
+		cap = font->kerns_cap ? font->kerns_cap * 2 : 256;
+		slots = calloc(cap, sizeof(*slots));
+		if (!slots) {
+			return -1;
+		}
+
+		for (i = 0; i < font->kerns_cap; i++) {
+			if (!font->kerns[i].used) {
+				continue;
+			}
+
+			for (j = font_glyphhash(font->kerns[i].b, font->kerns[i].a, 0) & (cap - 1); slots[j].used; j = (j + 1) & (cap - 1))
+				;
+
+			slots[j] = font->kerns[i];
+		}
+
+		free(font->kerns);
+
+		font->kerns = slots;
+		font->kerns_cap = cap;
 	}
 
-	for (i = 0; i < show->fonts_len; i++) {
-		if (streq(show->fonts[i].name, argv[1])) {
-			show->settings.fontidx = i;
+	for (i = font_glyphhash(b, a, 0) & (font->kerns_cap - 1); font->kerns[i].used; i = (i + 1) & (font->kerns_cap - 1)) {
+		if (font->kerns[i].a == a && font->kerns[i].b == b) {
 			return 0;
 		}
 	}
 
-	ERR("Couldn't find font '%s'\n", argv[1]);
+	font->kerns[i].a = a;
+	font->kerns[i].b = b;
+	font->kerns[i].kern = stbtt_GetCodepointKernAdvance(&font->info, a, b);
+	font->kerns[i].used = 1;
 
-	return -1;
+	font->kerns_len++;
+
+	return 0;
 }
 
-/* func_fontsizeset : user function ; sets the font size */
-int func_fontsizeset(struct show_t *show, int argc, char **argv)
+/* font_kern : returns the kerning between a and b at 'fontsize', in 26.6 fixed point */
+s32 font_kern(struct font_t *font, u32 a, u32 b, u32 fontsize)
 {
-	assert(show);
+	struct kernpair_t *pair;
+	size_t i;
 
-	if (argc < 2) {
-		return -1;
+	if (!font->kerns_cap) {
+		return 0;
 	}
 
-	show->settings.fontsize = atoi(argv[1]);
+	for (i = font_glyphhash(b, a, 0) & (font->kerns_cap - 1); font->kerns[i].used; i = (i + 1) & (font->kerns_cap - 1)) {
+		pair = font->kerns + i;
+		if (pair->a == a && pair->b == b) {
+			return pair->kern ? (s32)floorf(pair->kern * font_scale(font, fontsize) * 64 + 0.5f) : 0;
+		}
+	}
 
+	// pairs show_snapshot never saw don't kern
 	return 0;
 }
 
-/* func_imageadd : user function ; loads an image, to be run once */
-int func_imageadd(struct show_t *show, int argc, char **argv)
+/* font_advance : returns how far 'codepoint' moves the pen at 'fontsize', in 26.6 fixed point */
+s32 font_advance(struct font_t *font, u32 codepoint, u32 fontsize)
 {
-	return 0;
-}
+	s32 advance, lsb;
 
-/* func_imagedraw : user function ; draws the image in an argument dependent way */
-int func_imagedraw(struct show_t *show, int argc, char **argv)
-{
-	return 0;
+	// NOTE (brian): straight from the font, so layout never needs a rasterized glyph
+	if (codepoint < ARRSIZE(font->advances)) {
+		advance = font->advances[codepoint];
+	} else {
+		stbtt_GetCodepointHMetrics(&font->info, (int)codepoint, &advance, &lsb);
+	}
+
+	return (s32)floorf(advance * font_scale(font, fontsize) * 64 + 0.5f);
 }
 
-/* func_nop : user(ish) function ; does nothing */
-int func_nop(struct show_t *show, int argc, char **argv)
+/* font_subpixel : splits the 26.6 pen position into a whole pixel 'x', returns the glyph offset to draw it with */
+u32 font_subpixel(s32 pen, s32 *x)
 {
-	return 0;
-}
+	u32 subx;
 
-//
-// Utility Functions
-//
+	// round to the nearest offset, rounding up past the last one lands on the next pixel
+	subx = ((pen & 63) * SUBPIXEL_STEPS + 32) >> 6;
 
-/* util_framebuffer : (re)sets the show's internal framebuffer */
-int util_framebuffer(struct show_t *show)
+	*x = (pen >> 6) + (subx == SUBPIXEL_STEPS);
+
+	return subx % SUBPIXEL_STEPS;
+}
+
+/* font_glyph : returns the glyph for 'codepoint' in the show's current font size, at offset 'subx' */
+struct fchar_t *font_glyph(struct show_t *show, struct font_t *font, u32 codepoint, u32 subx)
 {
-	s32 i;
-	s32 pixels;
+	struct glyphcache_t *cache;
+	struct fchar_t *fchar;
+	u32 fontsize;
 
-	assert(show);
+	cache = &show->glyphs;
+	fontsize = show->settings.fontsize;
 
-	pixels = show->settings.img_w * show->settings.img_h;
+	if (codepoint >= ARRSIZE(cache->ascii[0])) {
+		return font_getcodepoint(font, codepoint, fontsize, show->glyphmode, subx, &show->scratch);
+	}
 
-	for (i = 0; i < ARRSIZE(show->framebuffers); i++) {
-		free(show->framebuffers[i]);
-		show->framebuffers[i] = calloc(pixels, sizeof(struct pixel_t));
+	if (cache->font != font || cache->fontsize != fontsize || cache->mode != show->glyphmode) {
+		memset(cache->ascii, 0, sizeof cache->ascii);
+		cache->font = font;
+		cache->fontsize = fontsize;
+		cache->mode = show->glyphmode;
 	}
 
-	return 0;
-}
+	fchar = cache->ascii[subx][codepoint];
+	if (fchar) {
+		cache->hits++;
+		return fchar;
+	}
 
-/* util_setdefaults : sets default settings */
-int util_setdefaults(struct show_t *show)
-{
-	assert(show);
+	fchar = font_getcodepoint(font, codepoint, fontsize, show->glyphmode, subx, &show->scratch);
 
-	memset(&show->defaults, 0, sizeof show->defaults);
+	cache->ascii[subx][codepoint] = fchar;
 
-	return 0;
+	return fchar;
 }
 
-/* util_slidecount : counts the number of slides in the slideshow */
-int util_slidecount(struct show_t *show)
+/* font_report : prints glyph cache hit rates */
+void font_report(struct show_t *show)
 {
-	s32 i, rc;
-
-	assert(show);
-
-	for (i = 0, rc = 0; i < show->commands_len; i++) {
-		if (streq(show->commands[i].argv[0], "newslide")) {
-			rc++;
-		}
+	u64 hits, misses, lookups;
+	u64 run_hits, run_misses;
+	size_t i, glyphs, pages, bytes, disk, sdf, runs, strips, strip_bytes, mapped;
+
+	run_hits = run_misses = 0;
+	runs = strips = strip_bytes = mapped = 0;
+
+	for (i = 0, hits = misses = glyphs = pages = bytes = disk = sdf = 0; i < show->fonts_len; i++) {
+		mapped += show->fonts[i].ttfsize;
+		run_hits += show->fonts[i].run_hits;
+		run_misses += show->fonts[i].run_misses;
+		runs += show->fonts[i].runs_len;
+		strips += show->fonts[i].strips;
+		strip_bytes += show->fonts[i].strip_bytes;
+		hits += show->fonts[i].hits;
+		disk += show->fonts[i].disk_glyphs;
+		sdf += show->fonts[i].sdf_bytes;
+		misses += show->fonts[i].misses;
+		glyphs += show->fonts[i].ftab_len;
+		pages += show->fonts[i].atlas_pages;
+		bytes += show->fonts[i].atlas_bytes;
 	}
 
-	return rc;
-}
+	lookups = show->glyphs.hits + hits + misses;
 
-/* util_getfuncidx : gets the function index */
-int util_getfuncidx(struct show_t *show, char *function)
-{
-	s32 i;
+	fprintf(stderr, "fonts: %zu names, %zu files, %.1f MB mapped\n", show->fontnames_len, show->fonts_len,
+			mapped / (f64)(1 << 20));
+	fprintf(stderr, "glyphs: %llu lookups, %llu ascii hits, %llu table hits, %llu misses (%.1f%% hit), %zu cached\n",
+			lookups, show->glyphs.hits, hits, misses, lookups ? 100.0 * (lookups - misses) / lookups : 0.0, glyphs);
+	fprintf(stderr, "atlas: %zu pages, %.1f MB\n", pages, bytes / (f64)(1 << 20));
+	fprintf(stderr, "text runs: %llu lookups, %llu hits (%.1f%% hit), %zu cached, %zu strips, %.1f MB\n",
+			run_hits + run_misses, run_hits, run_hits + run_misses ? 100.0 * run_hits / (run_hits + run_misses) : 0.0,
+			runs, strips, strip_bytes / (f64)(1 << 20));
 
-	assert(show);
-	assert(function);
+	if (show->glyphmode == GLYPHMODE_SDF) {
+		fprintf(stderr, "distance fields: %.1f MB\n", sdf / (f64)(1 << 20));
+	}
 
-	for (i = 0; i < show->functions_len; i++) {
-		if (streq(show->functions[i].name, function)) {
-			return i;
-		}
+	if (show->glyphdir) {
+		fprintf(stderr, "glyph cache: %zu of %zu glyphs loaded from disk\n", disk, glyphs);
 	}
+}
 
-	return -1;
+/* font_diskpath : puts the path of the font's on disk glyph cache in 'buf' */
+int font_diskpath(struct font_t *font, char *dir, char *buf, size_t len)
+{
+	return snprintf(buf, len, "%s/%016llx.glyphs", dir, font->hash);
 }
 
-/* util_parsecolor : parses a color string into a color structure */
-struct color_t util_parsecolor(char *s)
+/* font_diskload : maps in the font's on disk glyph cache, and adds its glyphs to the table */
+int font_diskload(struct font_t *font, char *dir)
 {
-	struct color_t color;
-	u32 r, g, b, a;
-	s32 rc;
+	struct diskheader_t *header;
+	struct diskglyph_t *glyphs;
+	struct fchar_t *fchar;
+	char path[BUFLARGE];
+	size_t i;
 
-	memset(&color, 0, sizeof color);
+	// NOTE (brian): the cache is only ever a head start, if anything about it looks wrong, it gets
+	// ignored, and written over once the show renders
 
-	rc = sscanf(s, "0x%2x%2x%2x%2x", &r, &g, &b, &a);
+	assert(font);
 
-	if (rc != 3 && rc != 4) {
-		ERR("Color Parse Error! '%s'\n", s);
-		return color;
+	font_diskpath(font, dir, path, sizeof path);
+
+	font->disk = sys_mapfile(path, &font->disk_len);
+	if (!font->disk) {
+		return 0;
 	}
 
-	if (rc == 3) {
-		color.r = r;
-		color.g = g;
-		color.b = b;
-		color.a = 0xff;
+	header = (struct diskheader_t *)font->disk;
+	glyphs = (struct diskglyph_t *)(header + 1);
+
+	if (font->disk_len < sizeof(*header) || memcmp(header->magic, GLYPHCACHE_MAGIC, sizeof header->magic) != 0 ||
+			header->hash != font->hash ||
+			(font->disk_len - sizeof(*header)) / sizeof(*glyphs) < header->count) {
+		ERR("Ignoring the glyph cache '%s', it doesn't match the font\n", path);
+		sys_unmapfile(font->disk, font->disk_len);
+		font->disk = NULL;
+		font->disk_len = 0;
+		return -1;
 	}
 
-	if (rc == 4) {
-		color.a = a;
+	for (i = 0; i < header->count; i++) {
+		if (glyphs[i].f_x < 0 || glyphs[i].f_y < 0 || SUBPIXEL_STEPS <= glyphs[i].subx || font->disk_len < glyphs[i].offset ||
+				(font->disk_len - glyphs[i].offset) / MAX(glyphs[i].f_y, 1) < glyphs[i].f_x) {
+			continue;
+		}
+
+		if (font_findcodepoint(font, glyphs[i].codepoint, glyphs[i].fontsize, glyphs[i].mode, glyphs[i].subx)) {
+			continue;
+		}
+
+		fchar = arena_calloc(&font->arena, 1, sizeof(*fchar));
+		if (!fchar) {
+			return -1;
+		}
+
+		fchar->coverage  = (u8 *)font->disk + glyphs[i].offset;
+		fchar->stride    = glyphs[i].f_x;
+		fchar->codepoint = glyphs[i].codepoint;
+		fchar->fontsize  = glyphs[i].fontsize;
+		fchar->mode      = glyphs[i].mode;
+		fchar->subx      = glyphs[i].subx;
+		fchar->f_x       = glyphs[i].f_x;
+		fchar->f_y       = glyphs[i].f_y;
+		fchar->b_x       = glyphs[i].b_x;
+		fchar->b_y       = glyphs[i].b_y;
+		fchar->advance   = glyphs[i].advance;
+
+		font_insertcodepoint(font, fchar);
 	}
 
-	return color;
+	font->disk_glyphs = font->ftab_len;
+
+	return 0;
 }
 
-/* util_rect : utility function to fill out a rectangle */
-struct rect_t util_rect(s32 x, s32 y, s32 w, s32 h)
+/* font_disksave : writes the font's glyph table out to its on disk glyph cache */
+int font_disksave(struct font_t *font, char *dir)
 {
-	struct rect_t r;
+	struct diskheader_t header;
+	struct diskglyph_t glyph;
+	struct fchar_t *fchar;
+	char path[BUFLARGE];
+	char tmp[BUFLARGE + 32];
+	FILE *fp;
+	size_t i;
+	u64 offset;
+	s32 y;
 
-	r.x = x;
-	r.y = y;
-	r.w = w;
-	r.h = h;
+	// NOTE (brian): the file gets written off to the side, then renamed over the old one, so any
+	// other run that has the old one mapped (or is reading it) never sees half a file
 
-	return r;
-}
+	assert(font);
 
-//
-// Framebuffer Functions
-//
+	if (!font->name || font->ftab_len == font->disk_glyphs) {
+		return 0;
+	}
 
-/* draw_rect : blits a rectangle */
-int draw_rect(struct pixel_t *dst, struct pixel_t *src, struct rect_t dstdim, struct rect_t srcdim, struct rect_t dstrect, struct rect_t srcrect, int blend)
-{
-	s32 x, y;
-	s32 src_x, src_y;
-	s32 dst_x, dst_y;
-	s32 src_idx, dst_idx;
-	struct pixel_t dst_pix, src_pix;
-	f32 alpha;
+	mkdir(dir, 0755);
 
-	// NOTE (brian): this function assumes that you've already done the work to scale the src to the
-	// destination's dimensions.
+	font_diskpath(font, dir, path, sizeof path);
+	snprintf(tmp, sizeof tmp, "%s.%d.tmp", path, (s32)getpid());
 
-	assert(dstdim.x == 0);
-	assert(dstdim.y == 0);
-	assert(srcdim.x == 0);
-	assert(srcdim.y == 0);
+	fp = fopen(tmp, "wb");
+	if (!fp) {
+		ERR("Couldn't write the glyph cache '%s'\n", tmp);
+		return -1;
+	}
 
-	for (x = srcrect.x; x < srcrect.w; x++) {
-		for (y = srcrect.y; y < srcrect.h; y++) {
-			src_x = x;
-			src_y = y;
-			dst_x = dstrect.x + x;
-			dst_y = dstrect.y + y;
+	memset(&header, 0, sizeof header);
+	memcpy(header.magic, GLYPHCACHE_MAGIC, sizeof header.magic);
+	header.hash = font->hash;
+	header.count = font->ftab_len;
 
-			// check for errors (src)
-			if (src_x < srcdim.x || src_x > srcdim.w) {
-				continue;
-			}
+	fwrite(&header, sizeof header, 1, fp);
 
-			if (src_y < srcdim.y || src_y > srcdim.h) {
-				continue;
-			}
+	offset = sizeof header + font->ftab_len * sizeof glyph;
 
-			// check for errors (dst)
-			if (dst_x < dstdim.x || dst_x > dstdim.w) {
-				continue;
-			}
+	for (i = 0; i < font->ftab_cap; i++) {
+		fchar = font->ftab[i];
+		if (!fchar) {
+			continue;
+		}
 
-			if (dst_y < dstdim.y || dst_y > dstdim.h) {
-				continue;
-			}
+		memset(&glyph, 0, sizeof glyph);
 
-			src_idx = src_x + src_y * srcdim.w;
-			src_pix = src[src_idx];
-
-			dst_idx = dst_x + dst_y * dstdim.w;
-			dst_pix = dst[dst_idx];
-
-			if (blend) {
-				alpha = src_pix.a * 1.0f / 255.0f;
-				dst_pix.r = m_lblend_u8(dst_pix.r, src_pix.r, alpha);
-				dst_pix.g = m_lblend_u8(dst_pix.g, src_pix.g, alpha);
-				dst_pix.b = m_lblend_u8(dst_pix.b, src_pix.b, alpha);
-				dst_pix.a = 0xff;
-			} else {
-				dst_pix.r = src_pix.r;
-				dst_pix.g = src_pix.g;
-				dst_pix.b = src_pix.b;
-				dst_pix.a = src_pix.a;
-			}
+		glyph.codepoint = fchar->codepoint;
+		glyph.fontsize  = fchar->fontsize;
+		glyph.mode      = fchar->mode;
+		glyph.subx      = fchar->subx;
+		glyph.f_x       = fchar->f_x;
+		glyph.f_y       = fchar->f_y;
+		glyph.b_x       = fchar->b_x;
+		glyph.b_y       = fchar->b_y;
+		glyph.advance   = fchar->advance;
+		glyph.offset    = offset;
+
+		fwrite(&glyph, sizeof glyph, 1, fp);
+
+		offset += (u64)fchar->f_x * fchar->f_y;
+	}
 
-			dst[dst_idx] = dst_pix;
+	// then the coverage, in the same order
+	for (i = 0; i < font->ftab_cap; i++) {
+		fchar = font->ftab[i];
+		for (y = 0; fchar && y < fchar->f_y; y++) {
+			fwrite(fchar->coverage + y * fchar->stride, 1, fchar->f_x, fp);
 		}
 	}
 
+	if (ferror(fp) | fclose(fp) || rename(tmp, path) < 0) {
+		ERR("Couldn't write the glyph cache '%s'\n", path);
+		remove(tmp);
+		return -1;
+	}
+
+	font->disk_glyphs = font->ftab_len;
+
 	return 0;
 }
 
+/* font_vertadvance : returns the font's vertical advance at 'fontsize' */
+s32 font_vertadvance(struct font_t *font, u32 fontsize)
+{
+	struct fmetrics_t *metrics;
+	f32 scale;
 
-//
-// Font Functions
-//
+	metrics = font_metrics(font, fontsize);
+	if (metrics) {
+		return metrics->vertadvance;
+	}
 
-/* font_load : sets up an entry in the font table with these params */
-s32 font_load(struct font_t *font, char *name, char *path)
-{
-	assert(font);
+	// sizes show_snapshot never saw never print anything, but still get the right answer
+	scale = font_scale(font, fontsize);
 
-	font->name = strdup(name);
-	font->path = strdup(path);
-	font->ttfbuffer = sys_readfile(path);
+	return (s32)(font->v_ascent * scale) - (s32)(font->v_descent * scale) + (s32)(font->v_linegap * scale);
+}
 
-	return 0;
+/* font_scale : returns the scale that makes the font 'fontsize' pixels tall */
+f32 font_scale(struct font_t *font, u32 fontsize)
+{
+	// NOTE (brian): this is stbtt_ScaleForPixelHeight, off of the metrics font_load already read
+	return (f32)fontsize / (font->v_ascent - font->v_descent);
 }
 
-/* font_getcodepoint : retrieves the fchar_t from input font and codepoint */
-struct fchar_t *font_getcodepoint(struct font_t *font, u32 codepoint, u32 fontsize)
+/* font_metricsadd : adds the font's vertical metrics at 'fontsize' to its table, if they aren't already there */
+int font_metricsadd(struct font_t *font, u32 fontsize)
 {
-	s32 i;
+	struct fmetrics_t *slots, *metrics;
+	size_t i, j, cap;
+	f32 scale;
 
-	// NOTE (brian): search for the codepoint in the fonttable. if it's there and rendered for the
-	// given size, return it. Otherwise, render the character for the required fontsize, insert it
-	// into the table, then return it.
+	// NOTE (brian): same scheme as the kerning table, keyed with font_glyphhash on the size alone.
+	// A show only ever prints at a handful of sizes, so this stays tiny.
 
-	for (i = 0; i < font->ftab_len; i++) {
-		if (font->ftab[i].codepoint == codepoint && font->ftab[i].fontsize == fontsize) {
-			return font->ftab + i;
+	if (font->metrics_cap <= (font->metrics_len + 1) * 2) {
+		cap = font->metrics_cap ? font->metrics_cap * 2 : 16;
+		slots = calloc(cap, sizeof(*slots));
+		if (!slots) {
+			return -1;
 		}
-	}
 
-	// NOTE (brian) if we get here, we didn't find the codepoint, so we
-	// have to render a new one
+		for (i = 0; i < font->metrics_cap; i++) {
+			if (!font->metrics[i].used) {
+				continue;
+			}
 
-	C_RESIZE(&font->ftab, &font->ftab, sizeof(*font->ftab));
+			for (j = font_glyphhash(0, font->metrics[i].fontsize, 0) & (cap - 1); slots[j].used; j = (j + 1) & (cap - 1))
+				;
 
-	stbtt_fontinfo fontinfo;
+			slots[j] = font->metrics[i];
+		}
 
-	f32 scale_x, scale_y;
-	s32 w, h, xoff, yoff, advance, lsb;
-	u8 *alpha_bitmap;
+		free(font->metrics);
 
-	stbtt_InitFont(&fontinfo, (unsigned char *)font->ttfbuffer, stbtt_GetFontOffsetForIndex((unsigned char *)font->ttfbuffer, 0));
-	scale_y = stbtt_ScaleForPixelHeight(&fontinfo, fontsize);
-	scale_x = scale_y;
+		font->metrics = slots;
+		font->metrics_cap = cap;
+	}
+
+	for (i = font_glyphhash(0, fontsize, 0) & (font->metrics_cap - 1); font->metrics[i].used; i = (i + 1) & (font->metrics_cap - 1)) {
+		if (font->metrics[i].fontsize == fontsize) {
+			return 0;
+		}
+	}
 
-	alpha_bitmap = stbtt_GetCodepointBitmap(&fontinfo, scale_x, scale_y, codepoint, &w, &h, &xoff, &yoff);
+	scale = font_scale(font, fontsize);
 
-	stbtt_GetCodepointHMetrics(&fontinfo, (int)codepoint, &advance, &lsb);
+	metrics = font->metrics + i;
 
-	// if this is the first time through here, we can get our 
-	if (!font->metricsread) {
-		stbtt_GetFontVMetrics(&fontinfo, &font->ascent, &font->descent, &font->linegap);
-		font->scale_x = scale_x;
-		font->scale_y = scale_y;
-		font->ascent *= scale_y;
-		font->descent *= scale_y;
-		font->linegap *= scale_y;
-		font->metricsread = true;
-	}
+	metrics->fontsize = fontsize;
+	metrics->scale = scale;
+	metrics->ascent = font->v_ascent * scale;
+	metrics->descent = font->v_descent * scale;
+	metrics->linegap = font->v_linegap * scale;
+	metrics->vertadvance = metrics->ascent - metrics->descent + metrics->linegap;
+	metrics->used = 1;
 
-	struct pixel_t *rgba_bitmap;
+	font->metrics_len++;
 
-	rgba_bitmap = calloc(w * h, sizeof(struct pixel_t));
+	return 0;
+}
 
-	assert(rgba_bitmap);
+/* font_metrics : returns the font's vertical metrics at 'fontsize', NULL if font_metricsadd never saw it */
+struct fmetrics_t *font_metrics(struct font_t *font, u32 fontsize)
+{
+	size_t i;
 
-	for (i = 0; i < w * h; i++) {
-		rgba_bitmap[i].r = 0xff;
-		rgba_bitmap[i].g = 0xff;
-		rgba_bitmap[i].b = 0xff;
-		rgba_bitmap[i].a = alpha_bitmap[i];
+	if (!font->metrics_cap) {
+		return NULL;
 	}
 
-	font->ftab[font->ftab_len].bitmap  = rgba_bitmap;
-	font->ftab[font->ftab_len].f_x     = w;
-	font->ftab[font->ftab_len].f_y     = h;
-	font->ftab[font->ftab_len].b_x     = xoff;
-	font->ftab[font->ftab_len].b_y     = yoff;
-	font->ftab[font->ftab_len].advance = advance * scale_x;
+	for (i = font_glyphhash(0, fontsize, 0) & (font->metrics_cap - 1); font->metrics[i].used; i = (i + 1) & (font->metrics_cap - 1)) {
+		if (font->metrics[i].fontsize == fontsize) {
+			return font->metrics + i;
+		}
+	}
 
-	return font->ftab + font->ftab_len++;
+	return NULL;
 }
 
-/* font_vertadvance : returns the font's vertical advance */
-s32 font_vertadvance(struct font_t *font)
+/* font_free : frees all fonts associated with the slideshow */
+s32 font_free(struct show_t *show)
 {
-	return font->ascent - font->descent + font->linegap;
+	size_t i;
+
+	assert(show);
+
+	for (i = 0; i < show->fonts_len; i++) {
+		font_fontfree(show->fonts + i);
+	}
+
+	free(show->fonts);
+
+	show->fonts = NULL;
+	show->fonts_len = show->fonts_cap = 0;
+
+	return 0;
 }
 
 /* font_fontfree : frees all resources associated with the font */
 int font_fontfree(struct font_t *font)
 {
-	size_t i;
+	// NOTE (brian): watch mode zeroes out fonts the next show took over, those have nothing to free
+	if (!font || !font->name) {
+		return 0;
+	}
 
-	if (font) {
-		for (i = 0; i < font->ftab_len; i++) {
-			if (font->ftab[i].bitmap) {
-				free(font->ftab[i].bitmap);
-			}
-		}
+	pthread_rwlock_destroy(font->lock);
+
+	sys_unmapfile(font->ttfbuffer, font->ttfsize);
+	free(font->ftab);
+	free(font->kerns);
+	free(font->metrics);
+	free(font->runs);
+
+	if (font->disk) {
+		sys_unmapfile(font->disk, font->disk_len);
 	}
 
+	// the name, path and glyphs
+	arena_free(&font->arena);
+
+	memset(font, 0, sizeof(*font));
+
 	return 0;
 }
 
@@ -33,6 +33,13 @@
 
 #include <assert.h>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #define SWAP(x, y, T) do { T SWAP = x; x = y; y = SWAP; } while (0)
 
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
@@ -83,6 +90,53 @@ void c_resize(void *ptr, size_t *len, size_t *cap, size_t bytes);
 
 #define C_RESIZE(x,y,z) (c_resize((x),y##_len,y##_cap,z))
 
+// NOTE (brian): a slice is a view into someone else's memory, it is NOT NULL terminated
+struct slice_t {
+	char *s;
+	size_t len;
+};
+
+// for printf, as in printf("%.*s", SLICE_ARG(slice))
+#define SLICE_ARG(x) ((int)(x).len), ((x).s)
+
+// NOTE (brian): an arena hands memory out of big blocks with a bump pointer, and takes it all back
+// in one go. A zeroed arena_t is ready to use. Arenas aren't thread safe.
+struct arena_block_t {
+	struct arena_block_t *next;
+	size_t cap;
+	size_t used;
+};
+
+struct arena_t {
+	struct arena_block_t *head; // the block allocations come out of, older blocks follow it
+	size_t blocksize;           // 0 means ARENA_BLOCKSIZE
+	size_t total;               // bytes handed out since the last reset
+};
+
+#define ARENA_BLOCKSIZE (1 << 16)
+#define ARENA_ALIGN     (16)
+#define ARENA_HEADER    ((sizeof(struct arena_block_t) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+/* arena_alloc : returns 'bytes' of uninitialized memory from the arena */
+void *arena_alloc(struct arena_t *arena, size_t bytes);
+/* arena_calloc : returns zeroed memory for 'n' elements of 'size' bytes from the arena */
+void *arena_calloc(struct arena_t *arena, size_t n, size_t size);
+/* arena_strdup : strdup, into the arena */
+char *arena_strdup(struct arena_t *arena, char *s);
+/* arena_slicedup : slice_dup, into the arena */
+char *arena_slicedup(struct arena_t *arena, struct slice_t a);
+/* arena_reset : takes back everything handed out, but keeps the memory */
+void arena_reset(struct arena_t *arena);
+/* arena_free : frees all of the arena's memory */
+void arena_free(struct arena_t *arena);
+
+/* slice_eq : return true if the slice and the string are equal */
+int slice_eq(struct slice_t a, char *s);
+/* slice_dup : returns a NULL terminated copy of the slice */
+char *slice_dup(struct slice_t a);
+/* slice_atoi : stdlib's atoi, on a slice */
+s32 slice_atoi(struct slice_t a);
+
 /* sql_fmtstr : formats an input string into the dst, sql ready */
 int sql_fmtstr(char *dst, char *src, size_t dstlen);
 
@@ -110,6 +164,21 @@ char *strornull(char *s);
 /* sys_readfile : reads an entire file into a memory buffer */
 char *sys_readfile(char *path);
 
+/* sys_readfilelen : sys_readfile, but also hands back the file's size */
+char *sys_readfilelen(char *path, size_t *len);
+
+/* sys_mapfile : maps an entire file into memory, read only */
+char *sys_mapfile(char *path, size_t *len);
+
+/* sys_unmapfile : unmaps a file from sys_mapfile */
+void sys_unmapfile(char *p, size_t len);
+
+/* sys_fileid : puts the file's device and inode in 'id', so two paths to one file compare equal */
+int sys_fileid(char *path, u64 *id);
+
+/* sys_nanotime : monotonic clock, in nanoseconds */
+u64 sys_nanotime(void);
+
 /* mkguid : puts a guid in the buffer if it's long enough */
 int mkguid(char *buf, size_t len);
 
@@ -143,6 +212,14 @@ int c_cmp_strstr(const void *a, const void *b);
 /* strdup_null : duplicates the string if non-null, returns NULL otherwise */
 char *strdup_null(char *s);
 
+/* c_hash : 64 bit FNV-1a hash of 'len' bytes, chained through 'seed' */
+u64 c_hash(void *p, size_t len, u64 seed);
+
+/* c_strhash : c_hash over a NULL terminated string */
+u64 c_strhash(char *s);
+
+#define C_HASHSEED (0xcbf29ce484222325ULL)
+
 /* c_fprintf : common printf logging routine, with some extra pizzaz */
 int c_fprintf(char *file, int line, const char *func, int level, FILE *fp, char *fmt, ...);
 
@@ -258,7 +335,7 @@ int sql_fmtstr(char *dst, char *src, size_t dstlen)
 /* ltrim : removes whitespace on the "left" (start) of the string */
 char *ltrim(char *s)
 {
-	while (isspace(*s))
+	while (isspace((unsigned char)*s))
 		s++;
 
 	return s;
@@ -269,7 +346,7 @@ char *rtrim(char *s)
 {
 	char *e;
 
-	for (e = s + strlen(s) - 1; isspace(*e); e--)
+	for (e = s + strlen(s) - 1; isspace((unsigned char)*e); e--)
 		*e = 0;
 
 	return s;
@@ -440,11 +517,21 @@ char *bstrtok(char **str, char *delim)
 
 /* sys_readfile : reads an entire file into a memory buffer */
 char *sys_readfile(char *path)
+{
+	size_t len;
+
+	return sys_readfilelen(path, &len);
+}
+
+/* sys_readfilelen : sys_readfile, but also hands back the file's size */
+char *sys_readfilelen(char *path, size_t *len)
 {
 	FILE *fp;
 	s64 size;
 	char *buf;
 
+	*len = 0;
+
 	fp = fopen(path, "r");
 	if (!fp) {
 		return NULL;
@@ -458,12 +545,100 @@ char *sys_readfile(char *path)
 	buf = malloc(size + 1);
 	memset(buf, 0, size + 1);
 
-	fread(buf, 1, size, fp);
+	*len = fread(buf, 1, size, fp);
 	fclose(fp);
 
 	return buf;
 }
 
+/* sys_mapfile : maps an entire file into memory, read only */
+char *sys_mapfile(char *path, size_t *len)
+{
+#if defined(__unix__) || defined(__APPLE__)
+	struct stat st;
+	char *p;
+	int fd;
+
+	// NOTE (brian): an empty file can't be mapped, it gets a (non NULL) empty buffer instead, so
+	// don't hand the result of this to munmap, use sys_unmapfile
+
+	*len = 0;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return NULL;
+	}
+
+	if (fstat(fd, &st) < 0) {
+		close(fd);
+		return NULL;
+	}
+
+	if (st.st_size == 0) {
+		close(fd);
+		return calloc(1, 1);
+	}
+
+	p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (p == MAP_FAILED) {
+		return NULL;
+	}
+
+	*len = st.st_size;
+
+	return p;
+#else
+	return sys_readfilelen(path, len);
+#endif
+}
+
+/* sys_unmapfile : unmaps a file from sys_mapfile */
+void sys_unmapfile(char *p, size_t len)
+{
+#if defined(__unix__) || defined(__APPLE__)
+	if (len) {
+		munmap(p, len);
+	} else {
+		free(p);
+	}
+#else
+	free(p);
+#endif
+}
+
+/* sys_fileid : puts the file's device and inode in 'id', so two paths to one file compare equal */
+int sys_fileid(char *path, u64 *id)
+{
+#if defined(__unix__) || defined(__APPLE__)
+	struct stat st;
+
+	if (stat(path, &st) < 0) {
+		return -1;
+	}
+
+	id[0] = (u64)st.st_dev;
+	id[1] = (u64)st.st_ino;
+
+	return 0;
+#else
+	// no inodes to go by, callers compare paths instead
+	id[0] = id[1] = 0;
+	return -1;
+#endif
+}
+
+/* sys_nanotime : monotonic clock, in nanoseconds */
+u64 sys_nanotime(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (u64)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
 /* streq : return true if the strings are equal */
 int streq(char *s, char *t)
 {
@@ -482,13 +657,184 @@ int strneq(char *s, char *t)
 int is_num(char *s)
 {
 	while (s && *s) {
-		if (!isdigit(*s))
+		if (!isdigit((unsigned char)*s))
 			return 0;
 	}
 
 	return 1;
 }
 
+/* arena_alloc : returns 'bytes' of uninitialized memory from the arena */
+void *arena_alloc(struct arena_t *arena, size_t bytes)
+{
+	struct arena_block_t *block;
+	size_t cap;
+	u8 *p;
+
+	assert(arena);
+
+	bytes = (bytes + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+	block = arena->head;
+
+	if (!block || block->cap - block->used < bytes) {
+		cap = arena->blocksize ? arena->blocksize : ARENA_BLOCKSIZE;
+
+		block = malloc(ARENA_HEADER + MAX(cap, bytes));
+		if (!block) {
+			return NULL;
+		}
+
+		block->cap = MAX(cap, bytes);
+		block->used = 0;
+
+		// an allocation bigger than a block gets a block of its own, behind the current one, so
+		// the rest of the current one doesn't go to waste
+		if (cap < bytes && arena->head) {
+			block->next = arena->head->next;
+			arena->head->next = block;
+		} else {
+			block->next = arena->head;
+			arena->head = block;
+		}
+	}
+
+	p = (u8 *)block + ARENA_HEADER + block->used;
+
+	block->used += bytes;
+	arena->total += bytes;
+
+	return p;
+}
+
+/* arena_calloc : returns zeroed memory for 'n' elements of 'size' bytes from the arena */
+void *arena_calloc(struct arena_t *arena, size_t n, size_t size)
+{
+	void *p;
+
+	p = arena_alloc(arena, n * size);
+	if (p) {
+		memset(p, 0, n * size);
+	}
+
+	return p;
+}
+
+/* arena_strdup : strdup, into the arena */
+char *arena_strdup(struct arena_t *arena, char *s)
+{
+	struct slice_t a;
+
+	a.s = s;
+	a.len = strlen(s);
+
+	return arena_slicedup(arena, a);
+}
+
+/* arena_slicedup : slice_dup, into the arena */
+char *arena_slicedup(struct arena_t *arena, struct slice_t a)
+{
+	char *s;
+
+	s = arena_alloc(arena, a.len + 1);
+	if (s) {
+		memcpy(s, a.s, a.len);
+		s[a.len] = 0;
+	}
+
+	return s;
+}
+
+/* arena_reset : takes back everything handed out, but keeps the memory */
+void arena_reset(struct arena_t *arena)
+{
+	struct arena_block_t *block;
+	size_t cap;
+
+	assert(arena);
+
+	// NOTE (brian): if the arena had to grow, its blocks get traded in for one block that holds all
+	// of them, so the same work next time around fits without growing again
+	if (arena->head && arena->head->next) {
+		for (cap = 0, block = arena->head; block; block = block->next) {
+			cap += block->cap;
+		}
+
+		arena_free(arena);
+
+		block = malloc(ARENA_HEADER + cap);
+		if (block) {
+			block->next = NULL;
+			block->cap = cap;
+			arena->head = block;
+		}
+	}
+
+	if (arena->head) {
+		arena->head->used = 0;
+	}
+
+	arena->total = 0;
+}
+
+/* arena_free : frees all of the arena's memory */
+void arena_free(struct arena_t *arena)
+{
+	struct arena_block_t *block, *next;
+
+	assert(arena);
+
+	for (block = arena->head; block; block = next) {
+		next = block->next;
+		free(block);
+	}
+
+	arena->head = NULL;
+	arena->total = 0;
+}
+
+/* slice_eq : return true if the slice and the string are equal */
+int slice_eq(struct slice_t a, char *s)
+{
+	return strlen(s) == a.len && memcmp(a.s, s, a.len) == 0;
+}
+
+/* slice_dup : returns a NULL terminated copy of the slice */
+char *slice_dup(struct slice_t a)
+{
+	char *s;
+
+	s = malloc(a.len + 1);
+	if (s) {
+		memcpy(s, a.s, a.len);
+		s[a.len] = 0;
+	}
+
+	return s;
+}
+
+/* slice_atoi : stdlib's atoi, on a slice */
+s32 slice_atoi(struct slice_t a)
+{
+	size_t i;
+	s32 sign, n;
+
+	for (i = 0; i < a.len && isspace((unsigned char)a.s[i]); i++)
+		;
+
+	sign = 1;
+
+	if (i < a.len && (a.s[i] == '-' || a.s[i] == '+')) {
+		sign = a.s[i++] == '-' ? -1 : 1;
+	}
+
+	for (n = 0; i < a.len && isdigit((unsigned char)a.s[i]); i++) {
+		n = n * 10 + (a.s[i] - '0');
+	}
+
+	return sign * n;
+}
+
 /* c_atoi : stdlib's atoi, but returns 0 if the pointer is NULL */
 s32 c_atoi(char *s)
 {
@@ -500,7 +846,7 @@ int mklower(char *s)
 {
 	char *t;
 	for (t = s; *t; t++) {
-		*t = tolower(*t);
+		*t = tolower((unsigned char)*t);
 	}
 	return 0;
 }
@@ -510,7 +856,7 @@ int mkupper(char *s)
 {
 	char *t;
 	for (t = s; *t; t++) {
-		*t = toupper(*t);
+		*t = toupper((unsigned char)*t);
 	}
 	return 0;
 }
@@ -543,6 +889,28 @@ char *strdup_null(char *s)
 	return s ? strdup(s) : NULL;
 }
 
+/* c_hash : 64 bit FNV-1a hash of 'len' bytes, chained through 'seed' */
+u64 c_hash(void *p, size_t len, u64 seed)
+{
+	u8 *s;
+	size_t i;
+
+	// NOTE (brian): pass C_HASHSEED to start a new hash, or a previous result to keep hashing
+
+	for (i = 0, s = p; i < len; i++) {
+		seed ^= s[i];
+		seed *= 0x100000001b3ULL;
+	}
+
+	return seed;
+}
+
+/* c_strhash : c_hash over a NULL terminated string */
+u64 c_strhash(char *s)
+{
+	return c_hash(s, strlen(s), C_HASHSEED);
+}
+
 /* c_fprintf : common printf logging routine, with some extra pizzaz */
 int c_fprintf(char *file, int line, const char *func, int level, FILE *fp, char *fmt, ...)
 {